@@ -25,9 +25,15 @@ extern "C" {
 #include <crt_Timers.h> // internal object of CleanRTOS. Don't use it directly
 namespace crt
 {
-	constexpr uint32_t MAX_NOF_TIMERS = 100;
+	// MAX_NOF_TIMERS is set in crt_Config.h.
 	//typedef crt::Timers_template<MAX_NOF_TIMERS> Timers;
+	// Optional second template parameter: the timer queue engine (see crt_Timers.h), f.e.
+	// using Timers = Timers_template<MAX_NOF_TIMERS, TimerQueue_TimingWheel>; (or TimerQueue_BinaryHeap)
 	using Timers = Timers_template<MAX_NOF_TIMERS>;
+#ifdef CRT_TIMERS_RAM_BUDGET_BYTES
+	static_assert(Timers::getMemUsageBytes() <= (CRT_TIMERS_RAM_BUDGET_BYTES),
+	              "Timers exceeds CRT_TIMERS_RAM_BUDGET_BYTES: lower MAX_NOF_TIMERS (see crt_Config.h)");
+#endif
 	void cleanRTOS_init();
 }
 // end of internals.
@@ -36,7 +42,10 @@ namespace crt
 #include "crt_Queue.h"
 #include "crt_Time.h"
 #include "crt_Timer.h"
+#include "crt_IsrTimer.h"
 #include "crt_Pool.h"
+#include "crt_DeferredWork.h"
+#include "crt_EventDispatcher.h"
 
 //#include "crt_IHandler.h"
 //#include "crt_IHandlerListener.h"
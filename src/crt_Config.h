@@ -7,10 +7,115 @@
 //#define CRT_DEBUG_LOGGING - ook voor stm?
 #define CRT_HIGH_WATERMARK_INCREASE_LOGGING
 
+// Time source of crt::Time (see crt_Time.h):
+// Default: the DWT cycle counter, extended to 64 bits by the Time task.
+// CRT_TIME_SOURCE_TIM5: timer5, extended to 64 bits by its overflow interrupt. No Time task
+// (saves its stack), no periodic wakeups and no lost counts. Timer5 can't be used otherwise
+// (also not as the timebase of the HAL). Without it, stmHwTimer5.c compiles to nothing.
+//#define CRT_TIME_SOURCE_TIM5
+
+// Hardware timer mode used by Timers (see stmHwTimer2.h):
+// Default: one-shot mode. For every new first deadline, the counter is reset and restarted.
+// CRT_TIMER2_FREE_RUNNING: the counter of timer2 runs continuously, and the deadline is
+// programmed in compare register CCR1. No pause/resume (and loss of microseconds) around
+// every start/stop, and timer2_now() can be used as a microsecond clock.
+// CCR2..CCR4 remain available for other deadlines.
+//#define CRT_TIMER2_FREE_RUNNING
+
+// CRT_TIMER_BACKEND_LPTIM: Timers uses LPTIM1 (16 bits, on the 32.768kHz LSE) instead of timer2.
+// LPTIM1 keeps running in Stop modes (f.e. Stop2 on the STM32L4), and Timers then keeps its time
+// in LPTIM1 counts too, so timers stay alive and on time while the mcu sleeps deeply.
+// Resolution about 30.5 us. Only on chips with an LPTIM. Without it, stmHwLptim1.c compiles to nothing.
+// See crt_HwTimerBackend_Lptim.h.
+//#define CRT_TIMER_BACKEND_LPTIM
+
+// CRT_TIMER_DIRECT_ISR_DELIVERY: a Timer fire wakes its task directly from the timer interrupt,
+// with a direct-to-task notification, instead of via the LongTimerRelay task (a queue put and
+// an extra task switch).
+// Tasks then wait on their notification (see Task::waitEventFlags), so don't use the
+// task notifications of CleanRTOS tasks for anything else.
+//#define CRT_TIMER_DIRECT_ISR_DELIVERY
+
+// CRT_TASK_NOTIFICATION_EVENTS: the event bits of a Task (of its Flags, Queues and Timers) are kept
+// in its FreeRTOS direct-to-task notification value, instead of in a CMSIS event flags object.
+// Same wait/waitAny/waitAll/hasFired semantics, but faster, without the event group RAM per task,
+// and a set from an ISR wakes the task directly (no FreeRTOS timer service, see
+// tests/Timer/Test_cpu_load_jitter_crash.md). Requires FreeRTOS 10.4 or later (ulTaskNotifyValueClear).
+// It supersedes the Task part of CRT_TIMER_DIRECT_ISR_DELIVERY. Notification index 0 is used,
+// so don't use the task notifications of CleanRTOS tasks for anything else.
+// Clearing (f.e. Flag::clear) is not allowed from an ISR.
+//#define CRT_TASK_NOTIFICATION_EVENTS
+
+// CRT_MAX_NOF_WAITABLES: amount of waitables (Flags, Queues, Timers) that a single task can own.
+// Default (undefined): 24, each with its own event bit. Define it (up to 768) for a two-level event
+// mask: every 32 waitables share an event bit, which only wakes the task, and a bitmap per task
+// tells which of them fired. waitAny, waitAll and wait then take a WaitableSet: combine waitables
+// with + (f.e. waitAny(flagA + queueB)), not with | on getBitMask. Costs about 3 x 4 bytes per
+// 32 waitables per task, and a set on the stack per wait.
+//#define CRT_MAX_NOF_WAITABLES 256
+
+// CRT_TIMERS_MEASURE_ISR: Timers measures the duration of its timer interrupt handling
+// (see Timers::getIsrDurationCycles). Costs a few cycles per interrupt.
+//#define CRT_TIMERS_MEASURE_ISR
+
+// CRT_TIMERS_COMMAND_QUEUE: tasks post timer starts and stops in a lock-free ring, which is
+// emptied by the timer interrupt (triggered in software). Task-side timer operations then
+// never mask interrupts. Requires CRT_TIMER2_FREE_RUNNING (or CRT_TIMER_BACKEND_LPTIM). See crt_Timers.h.
+//#define CRT_TIMERS_COMMAND_QUEUE
+
+// CRT_TICKLESS_IDLE: when all tasks are blocked, the cpu sleeps (__WFI) without the FreeRTOS tick,
+// until the next FreeRTOS wakeup or the next deadline of Timers, whichever comes first.
+// Time keeps counting during the sleep (timer5), so getTimeMicroseconds stays continuous.
+// Requires CRT_TIME_SOURCE_TIM5, and in FreeRTOSConfig.h: #define configUSE_TICKLESS_IDLE 2
+// (CleanRTOS then provides vPortSuppressTicksAndSleep, see crt_TicklessIdle.cpp).
+//#define CRT_TICKLESS_IDLE
+
+// CRT_TIMER_STATISTICS: Timers keeps per timer statistics of the lateness of its fires
+// (see Timers::getStats and Timers::dumpStats). Costs about 70 bytes RAM per timer,
+// and a few cycles per fire.
+//#define CRT_TIMER_STATISTICS
+
+// CRT_TIMER_NO_NAMES: Timers doesn't store the names of the timers (they are only used in
+// printouts, like Timers::dumpStats). Saves a pointer of RAM per timer.
+//#define CRT_TIMER_NO_NAMES
+
+// CRT_TIMERS_RAM_BUDGET_BYTES: if defined, the build fails if the RAM of Timers
+// (Timers::getMemUsageBytes, all preallocated) exceeds it. Useful on small parts (F0/G0).
+// Lower MAX_NOF_TIMERS below (and/or TimerHandleInt, CRT_TIMER_NO_NAMES) to fit.
+//#define CRT_TIMERS_RAM_BUDGET_BYTES 2048
+
+// CRT_SIM: build for the host simulation (see src/internals/sim/crt_Sim.h): Time, Timers and
+// Timer run on a PC, on a virtual clock, f.e. for unit tests and benchmarks of the timer engines.
+// Define it on the command line of the host build (-DCRT_SIM). It implies the settings below.
+// The host-only sources under src/internals (sim, tests) compile to nothing without it.
+#ifdef CRT_SIM
+	#ifndef CRT_TIME_SOURCE_TIM5
+	#define CRT_TIME_SOURCE_TIM5			// timer5 is the virtual clock.
+	#endif
+	#define CRT_TIMER_BACKEND_SIM
+	#ifndef CRT_TIMER_DIRECT_ISR_DELIVERY
+	#define CRT_TIMER_DIRECT_ISR_DELIVERY	// no LongTimerRelay task runs in the simulation.
+	#endif
+#endif
+
+#ifdef __cplusplus // (the defines above are read by the .c files of the hardware timers as well)
 namespace crt
 {
 	const uint32_t MAX_MUTEXNESTING = 20;
 
+	// Amount of timers (Timer, IsrTimer and internal ones) that can exist at the same time.
+	// Their RAM is preallocated: about Timers::getMemUsagePerTimerBytes each.
+	constexpr int32_t MAX_NOF_TIMERS = 100;
+
+	// Integer type of a TimerHandle (signed, and must fit MAX_NOF_TIMERS).
+	// int16_t or int8_t saves RAM in the index pool of Timers, if MAX_NOF_TIMERS allows.
+	using TimerHandleInt = int32_t;
+
+	// Capacity of the command ring of Timers, if CRT_TIMERS_COMMAND_QUEUE is defined (power of 2).
+	// If it is full, a start or stop waits until the timer interrupt has emptied it.
+	const uint32_t TIMERS_COMMAND_QUEUE_SIZE = 16;
+
 	// below, the mutexIDs directly involved in this test can be found.
 	const uint32_t MutexID_Logger = (1 << 30);	// High ID, so can be nested very deeply.
 };
+#endif // __cplusplus
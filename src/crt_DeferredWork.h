@@ -0,0 +1,164 @@
+#pragma once
+
+extern "C" {
+	#include "crt_stm_hal.h"
+
+	#include "cmsis_os2.h"
+}
+
+#include <cstdint>
+#include <cassert>
+
+#include "crt_Task.h"
+#include "crt_MpscRing.h"
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace crt
+{
+	typedef void (*DeferredWorkFunction)(void* pArg, uint32_t payload);
+
+	struct DeferredWorkItem
+	{
+		DeferredWorkFunction function;
+		void* pArg;
+		uint32_t payload;
+	};
+
+	// DeferredWork is a worker task that runs small work items, posted by ISRs (or tasks),
+	// in task context: the "bottom half" of an interrupt handler.
+	// For example, IrqPin, UART or DMA handlers can offload their work to a shared DeferredWork,
+	// instead of each needing a task of their own.
+	//
+	// An item is a function pointer, a pointer and a 32 bit payload. post pushes it in a
+	// lock-free ring (see crt_MpscRing.h) and wakes the worker with a direct-to-task notification.
+	// (no queue, no FreeRTOS timer service)
+	// The worker runs the items in order, in batches of at most QUEUE_SIZE. After a full batch,
+	// it yields to tasks of the same priority.
+	// If the ring is full, post returns false and the item is counted in getNofOverflows.
+	// (the worker has no waitables of its own, so using its notification as a counter doesn't
+	// interfere with CRT_TASK_NOTIFICATION_EVENTS)
+	//
+	// For multiple priorities, create multiple DeferredWork objects, f.e.:
+	//   static crt::DeferredWork<16> urgentWork("urgentWork", osPriorityHigh, 1024);
+	//   static crt::DeferredWork<32> backgroundWork("backgroundWork", osPriorityBelowNormal, 1024);
+	//   ...
+	//   urgentWork.post(handleRxByte, &uart, byte); // in the ISR.
+	//
+	// Precondition of post from an ISR: its priority is allowed to call FreeRTOS FromISR functions
+	// (see configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY).
+	template <uint32_t QUEUE_SIZE>
+	class DeferredWork : public Task
+	{
+	private:
+		MpscRing<DeferredWorkItem, QUEUE_SIZE> ring;
+
+		volatile uint32_t nofOverflows;
+		uint32_t nofItemsDone;
+		uint32_t maxBatchSize;
+
+	public:
+		DeferredWork(const char *taskName, osPriority_t taskPriority, unsigned int taskSizeBytes) :
+		Task(taskName, taskPriority, taskSizeBytes), ring(), nofOverflows(0), nofItemsDone(0), maxBatchSize(0)
+		{
+			start();
+		}
+
+		// Callable from ISRs and tasks. Returns false if the ring was full (the item is dropped).
+		bool post(DeferredWorkFunction function, void* pArg, uint32_t payload = 0)
+		{
+			assert(function != nullptr);
+			if (!ring.tryPush(DeferredWorkItem{function, pArg, payload}))
+			{
+				countOverflow();
+				return false;
+			}
+			wakeWorker();
+			return true;
+		}
+
+		// Amount of items that were dropped because the ring was full.
+		inline uint32_t getNofOverflows()
+		{
+			return nofOverflows;
+		}
+
+		inline uint32_t getNofItemsDone()
+		{
+			return nofItemsDone;
+		}
+
+		// Largest amount of items that were run after a single wakeup.
+		inline uint32_t getMaxBatchSize()
+		{
+			return maxBatchSize;
+		}
+
+	private:
+		inline void countOverflow()
+		{
+			if (__get_IPSR() != 0U)
+			{
+				UBaseType_t savedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+				nofOverflows = nofOverflows + 1;
+				taskEXIT_CRITICAL_FROM_ISR(savedInterruptStatus);
+			}
+			else
+			{
+				taskENTER_CRITICAL();
+				nofOverflows = nofOverflows + 1;
+				taskEXIT_CRITICAL();
+			}
+		}
+
+		inline void wakeWorker()
+		{
+			if (__get_IPSR() != 0U)
+			{
+				BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+				vTaskNotifyGiveFromISR((TaskHandle_t)taskHandle, &xHigherPriorityTaskWoken);
+				portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+			}
+			else
+			{
+				xTaskNotifyGive((TaskHandle_t)taskHandle);
+			}
+		}
+
+		void main() override
+		{
+			while (true)
+			{
+				ulTaskNotifyTake(pdTRUE, portMAX_DELAY); // a notification given meanwhile is not lost: it counts.
+
+				runPostedItems();
+
+				// An item whose producer was preempted halfway a push, is run after its
+				// notification, at the next wakeup.
+				dumpStackHighWaterMarkIfIncreased();
+			}
+		}
+
+	protected:
+		// Runs the posted items till the ring is empty, including the items that are posted
+		// meanwhile. Returns the amount of items run. (the body of main after a wakeup, apart
+		// so that the host simulation can run it, see tests/Sim/crt_TestSim.cpp)
+		uint32_t runPostedItems()
+		{
+			uint32_t batchSize = 0;
+			DeferredWorkItem item;
+			while (ring.tryPop(item))
+			{
+				item.function(item.pArg, item.payload);
+				nofItemsDone++;
+				batchSize++;
+				if ((batchSize % QUEUE_SIZE) == 0)
+				{
+					osThreadYield(); // let tasks of the same priority in, in between batches.
+				}
+			}
+			if (batchSize > maxBatchSize) maxBatchSize = batchSize;
+			return batchSize;
+		}
+	}; // end class DeferredWork
+}; // end namespace crt
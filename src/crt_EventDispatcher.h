@@ -0,0 +1,136 @@
+// by Marius Versteegen, 2025
+
+// An EventDispatcher is an event loop helper for a task that waits for many waitables.
+// Instead of a waitAny followed by a chain of hasFired checks, the waitables are registered
+// once, each with a handler. dispatchNext then waits for any of them, and runs the handler of the
+// one with the highest priority.
+//
+// Priority: the waitable with the lowest bit number wins, that is, the waitable of the task that
+// was constructed first (f.e. the member that is declared first). It is found with a single
+// count trailing zeros (RBIT + CLZ on Cortex-M), and only its bit is cleared.
+// The others stay set, and are dispatched at the next calls.
+//
+// A queue is not cleared by the dispatcher: its handler must read (at least) one item,
+// like after hasFired.
+//
+// The dispatcher holds an entry (3 pointers) per bit number below its template argument
+// NOF_WAITABLES, so its size scales with it: 24 entries by default, but f.e. 768 entries (9 kB)
+// for EventDispatcher<MAX_NOF_WAITABLES> with CRT_MAX_NOF_WAITABLES=768. Make it a member of the
+// task (or static) rather than a local in its main, which would live on the (small) task stack.
+//
+// Example, with the dispatcher as a member of a task:
+//   EventDispatcher<> dispatcher;   // constructed with dispatcher(this) in the constructor of the task.
+//   ...
+//   static void onButton(void* pArg) { ((MyTask*)pArg)->handleButton(); }
+//   ...
+//   // in main:
+//   dispatcher.add(buttonFlag, onButton, this);
+//   dispatcher.add(rxQueue, onRx, this);
+//   dispatcher.add(blinkTimer, onBlink, this);
+//   while (true)
+//   {
+//       dispatcher.dispatchNext();
+//   }
+
+#pragma once
+
+extern "C" {
+	#include "crt_stm_hal.h"
+
+	#include "cmsis_os2.h"
+}
+
+#include <cassert>
+#include "crt_Waitable.h"
+#include "crt_Task.h"
+
+namespace crt
+{
+	typedef void (*EventHandler)(void* pArg);
+
+	// NOF_WAITABLES: the bit numbers of the registered waitables must be below it.
+	// The default fits the 24 waitables of a task without CRT_MAX_NOF_WAITABLES.
+	template <uint32_t NOF_WAITABLES = (MAX_NOF_WAITABLES < 24 ? MAX_NOF_WAITABLES : 24)>
+	class EventDispatcher
+	{
+		static_assert(NOF_WAITABLES <= MAX_NOF_WAITABLES, "EventDispatcher: NOF_WAITABLES exceeds MAX_NOF_WAITABLES");
+
+	private:
+		struct Entry
+		{
+			Waitable* pWaitable;
+			EventHandler handler;
+			void* pArg;
+		};
+
+		Task* pTask;
+		Entry arEntries[NOF_WAITABLES]; // indexed by the bit number of the waitable.
+#ifdef CRT_MAX_NOF_WAITABLES
+		WaitableSet registered;
+#else
+		uint32_t registered;
+#endif
+
+	public:
+		EventDispatcher(Task* pTask) : pTask(pTask), arEntries{}, registered()
+		{
+			assert(pTask != nullptr);
+		}
+
+		// The waitable must be owned by the task of this dispatcher.
+		void add(Waitable& waitable, EventHandler handler, void* pArg = nullptr)
+		{
+			assert(handler != nullptr);
+			assert(waitable.getBitNumber() < NOF_WAITABLES);
+			arEntries[waitable.getBitNumber()] = Entry{&waitable, handler, pArg};
+#ifdef CRT_MAX_NOF_WAITABLES
+			registered.add(waitable);
+#else
+			registered |= waitable.getBitMask();
+#endif
+		}
+
+		// Waits till a registered waitable has fired, and runs its handler.
+		inline void dispatchNext()
+		{
+			dispatchNext_ticks(osWaitForever);
+		}
+
+		// Returns false if no registered waitable fired within the timeout (see Task::waitAny_ticks).
+		inline bool dispatchNext_ticks(uint32_t timeout_ticks)
+		{
+			if (!pTask->waitAny_ticks(registered, timeout_ticks)) return false;
+
+			int32_t bitNumber = getFirstFired();
+			assert(bitNumber >= 0);
+			Entry& entry = arEntries[bitNumber];
+			if (entry.pWaitable->getType() != WaitableType::wt_Queue)
+			{
+				pTask->clearFired(*entry.pWaitable);
+			}
+			entry.handler(entry.pArg);
+			return true;
+		}
+
+		inline bool dispatchNext_us(uint64_t timeout_us)
+		{
+			return dispatchNext_ticks(Task::microsecondsToTicks(timeout_us));
+		}
+
+	private:
+		// The bit number of the fired waitable with the highest priority (-1 if none), after waitAny.
+		inline int32_t getFirstFired() const
+		{
+#ifdef CRT_MAX_NOF_WAITABLES
+			const WaitableSet& fired = pTask->latestFired; // only holds waitables of registered.
+			if (fired.groupMask == 0) return -1;
+			uint32_t group = (uint32_t)__builtin_ctz(fired.groupMask);
+			return (int32_t)(group * 32 + (uint32_t)__builtin_ctz(fired.arWords[group]));
+#else
+			uint32_t fired = pTask->latestResult & registered;
+			if (fired == 0) return -1;
+			return (int32_t)__builtin_ctz(fired);
+#endif
+		}
+	};
+};
@@ -51,13 +51,13 @@ namespace crt
         void set()
         {
             assert(pTask!=nullptr);
-            pTask->setEventBits(Waitable::getBitMask());
+            pTask->setFired(*this);
         }
 
 		void clear()
 		{
             assert(pTask!=nullptr);
-			pTask->clearEventBits(Waitable::getBitMask());
+			pTask->clearFired(*this);
 		}
     };
 };
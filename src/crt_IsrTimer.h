@@ -0,0 +1,113 @@
+#pragma once
+
+extern "C" {
+	#include "crt_stm_hal.h"
+
+	#include "cmsis_os2.h"
+}
+
+#include <cstdint>
+#include <cassert>
+
+#include "crt_CleanRTOS.h"   // defines using Timers = ...
+
+// An IsrTimer calls a user callback directly from the timer interrupt (Timers::handleHwTimerInterrupt),
+// instead of setting an event bit of a task. No relay, no task switch: for hard real-time actions
+// at an exact microsecond, like toggling a gpio or kicking a dma transfer.
+// (a Timer wakes a task: that adds the wakeup and at least one context switch)
+//
+// Constraints on the callback (it runs with the priority of the timer interrupt):
+// - Keep it short: all other timers (of all tasks) wait until it returns.
+// - Only use FreeRTOS functions that end with FromISR. (f.e. to wake a task: vTaskNotifyGiveFromISR)
+// - Don't start or stop timers from it (neither IsrTimers, nor Timers). For a repeating action,
+//   use start_periodic (with PeriodMode::FixedRate, it stays on its grid).
+// - Without CRT_TIMERS_COMMAND_QUEUE, a timer that is already due when a task starts or stops a timer,
+//   is fired by that call. Then the callback runs in the context of that task. So make the callback
+//   valid in both contexts (a gpio or register write is), or check __get_IPSR() != 0.
+//
+// Usage:
+//   static void onPulse(void* pArg) { HAL_GPIO_WritePin(GPIOA, GPIO_PIN_5, GPIO_PIN_SET); }
+//   crt::IsrTimer pulseTimer(onPulse);
+//   pulseTimer.start_periodic(1000, crt::PeriodMode::FixedRate); // from a task.
+//
+// Like Timer: don't destroy it before it is stopped (preallocate IsrTimers, and keep them).
+
+namespace crt
+{
+	class IsrTimer
+	{
+	public:
+		typedef void (*IsrCallback)(void* pArg);
+
+	private:
+		TimerHandle hTimer;
+		IsrCallback callback;
+		void* pArg;
+		const char* name;
+
+	public:
+		IsrTimer(IsrCallback callback, void* pArg = nullptr, const char* name = "IsrTimer") :
+		hTimer(Timers::TimerHandle_None), callback(callback), pArg(pArg), name(name)
+		{
+			assert(callback != nullptr);
+			// The timer is created at the first start: Timers may not exist yet during static construction.
+		}
+
+		void createIfNeeded()
+		{
+			if(crt::Timers::isValidTimerHandle(hTimer)) return; // already created
+			// The callback is passed as is: Timers calls it from its interrupt, without a wrapper.
+			hTimer = crt::Timers::createTimer(name, callback, pArg);
+			assert(crt::Timers::isValidTimerHandle(hTimer));
+		}
+
+		// The callback is called once, duration_us from now. (the engine overhead of Timers is
+		// compensated, see TimerCalibration. There is no task wakeup to compensate for)
+		// slack_us: see Timer::start.
+		// Call from a task (not from an ISR).
+		inline void start(uint64_t duration_us, uint32_t slack_us = 0)
+		{
+			assert(__get_IPSR() == 0U);
+			assert(duration_us >= Timers::minimumWaitTimeUs);	// assert against bad design (like start_periodic)
+			createIfNeeded();
+			crt::Timers::startTimer(hTimer, duration_us, false, PeriodMode::FixedDelay, OverrunPolicy::Skip, slack_us);
+		}
+
+		// The callback is called every period_us. See Timer::start_periodic.
+		// Call from a task (not from an ISR).
+		inline void start_periodic(uint64_t period_us,
+		                           PeriodMode periodMode = PeriodMode::FixedDelay,
+		                           OverrunPolicy overrunPolicy = OverrunPolicy::Skip,
+		                           uint32_t slack_us = 0)
+		{
+			assert(__get_IPSR() == 0U);
+			assert(period_us >= Timers::minimumWaitTimeUs);	// assert against bad design (it would load the cpu too much)
+			createIfNeeded();
+			crt::Timers::startTimer(hTimer, period_us, true, periodMode, overrunPolicy, slack_us);
+		}
+
+		// After stop returns, the callback is not called anymore (until the next start).
+		// Call from a task (not from an ISR).
+		inline void stop()
+		{
+			assert(__get_IPSR() == 0U);
+			if(!Timers::isValidTimerHandle(hTimer)) return;
+			crt::Timers::stopTimer(hTimer);
+		}
+
+		inline bool isRunning()
+		{
+			if(!Timers::isValidTimerHandle(hTimer)) return false;
+			return crt::Timers::isTimerRunning(hTimer);
+		}
+
+		// Amount of periods that were missed (see OverrunPolicy), since start_periodic with PeriodMode::FixedRate.
+		inline uint32_t getOverrunCount()
+		{
+			if(!Timers::isValidTimerHandle(hTimer)) return 0;
+			return crt::Timers::getOverrunCount(hTimer);
+		}
+
+		inline TimerHandle getTimerHandle(){return hTimer;}
+	}; // end class IsrTimer
+}; // end namespace crt
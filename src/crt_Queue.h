@@ -22,11 +22,12 @@ namespace crt
         Task* pTask;
         uint32_t writeDelay;
 		TYPE dummy;
+		volatile int32_t nofMessages; // Kept here, for the readiness of the queue for its task (see updateNofMessages).
 
 	public:
 		Queue(Task* pTask,bool bWriteWaitIfQueueFull=false)
 		: Waitable(WaitableType::wt_Queue),pTask(pTask),
-          writeDelay(bWriteWaitIfQueueFull ? osWaitForever : 0)
+          writeDelay(bWriteWaitIfQueueFull ? osWaitForever : 0), nofMessages(0)
 		{
 			if(pTask!=nullptr)
 			{
@@ -54,20 +55,9 @@ namespace crt
 
             if(pTask!=nullptr) 
 			{
-				if (osMessageQueueGetCount(qh) > 0)
-				{
-					// The queue is not empty yet,
-					// Make sure that the corresponding eventbit gets set again,
-					// Such that a wait for the queue will fire.
-					pTask->setEventBits(Waitable::getBitMask());
-				}
-				else
-				{
-					//!!! TODO: check esp32 version on this behaviour as well!
-					// Especially needed to explicitly clear at read, because wait_any
-					// and wait_all don't do that.
-					pTask->clearEventBits(Waitable::getBitMask());
-				}
+				// If the queue got empty, the task doesn't see it as ready anymore.
+				// (no kernel calls: the readiness is kept in user space)
+				updateNofMessages(-1);
 			}
 			//assert(rc == pdPASS);
 		}
@@ -85,7 +75,12 @@ namespace crt
             }
             if(pTask!=nullptr)
             {
-            	pTask->setEventBits(Waitable::getBitMask());
+            	if(updateNofMessages(1))
+            	{
+            		// The queue became ready: wake the task, if it waits for it.
+            		// (not at every message: as long as the queue holds messages, it stays ready)
+            		pTask->setEventBits(Waitable::getBitMask());
+            	}
             }
             return true;
 		}
@@ -110,12 +105,41 @@ namespace crt
 			while (osMessageQueueGetCount(qh) > 0)
 			{
 				osMessageQueueGet(qh, &dummy, nullptr, osWaitForever);
+				if(pTask!=nullptr)
+				{
+					updateNofMessages(-1);
+				}
 			}
+		}
 
-			if(pTask!=nullptr)
+	private:
+		// Readiness of the queue for its task: it is ready as long as it holds messages.
+		// The count is changed after the message is put or got, and the readiness is updated along,
+		// in the same critical section (a count of -1, for a message that was got before it was
+		// counted, is not ready). Returns true if the queue just became ready.
+		bool updateNofMessages(int32_t delta)
+		{
+			bool bWasReady;
+			bool bReady;
+			if (__get_IPSR() != 0U)
+			{
+				UBaseType_t savedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+				bWasReady = (nofMessages > 0);
+				nofMessages = nofMessages + delta;
+				bReady = (nofMessages > 0);
+				if (bReady != bWasReady) pTask->setQueueReady(*this, bReady);
+				taskEXIT_CRITICAL_FROM_ISR(savedInterruptStatus);
+			}
+			else
 			{
-				pTask->clearEventBits(Waitable::getBitMask());
+				taskENTER_CRITICAL();
+				bWasReady = (nofMessages > 0);
+				nofMessages = nofMessages + delta;
+				bReady = (nofMessages > 0);
+				if (bReady != bWasReady) pTask->setQueueReady(*this, bReady);
+				taskEXIT_CRITICAL();
 			}
+			return bReady && !bWasReady;
 		}
 	};
 };
@@ -14,6 +14,7 @@ extern "C" {
 #include "crt_Waitable.h"
 #include "crt_std_Stack.h"
 #include "FreeRTOS.h"
+#include "task.h"
 #include "event_groups.h"
 #include "c_printing.h"
 
@@ -35,10 +36,25 @@ namespace crt
         uint32_t timersMask;        // Every bit in this mask belongs to a timer.
 
         uint32_t latestResult;
+#ifdef CRT_MAX_NOF_WAITABLES
+        // Two-level event mask (see crt_Waitable.h). queuesMask, flagsMask and timersMask are not used.
+        volatile uint32_t arFiredWords[NOF_WAITABLE_GROUPS];	// per group: the waitables that have fired.
+        uint32_t arQueuesWords[NOF_WAITABLE_GROUPS];			// per group: the queues.
+        WaitableSet latestFired;								// the result of the latest waitAny (or wait).
+#else
+        volatile uint32_t queuesReady;	// the queues that hold messages (see setQueueReady).
+#endif
 		crt_std::Stack<uint32_t, MAX_MUTEXNESTING> mutexIdStack;
 
 	private:
+#if defined(CRT_TASK_NOTIFICATION_EVENTS)
+		// No event flags: the event bits are the notification value of the task (see crt_Config.h).
+#else
 		osEventFlagsId_t   hFlags;
+#ifdef CRT_TIMER_DIRECT_ISR_DELIVERY
+		volatile uint32_t  isrPendingBits; // set from ISRs, not yet moved to hFlags.
+#endif
+#endif
 
 	protected:
 		UBaseType_t prev_stack_hwm;
@@ -48,11 +64,24 @@ namespace crt
 		    : taskName(taskName), taskPriority(taskPriority),
 		      taskStackSizeBytes(taskStackSizeBytes), taskHandle(nullptr),
 		      nofWaitables(0), queuesMask(0), flagsMask(0), timersMask(0), latestResult(0),
-			  mutexIdStack(0) /* The value 0 is reserved for "empty stack*/, hFlags(nullptr),
+#ifdef CRT_MAX_NOF_WAITABLES
+			  arFiredWords{}, arQueuesWords{}, latestFired(),
+#else
+			  queuesReady(0),
+#endif
+			  mutexIdStack(0) /* The value 0 is reserved for "empty stack*/,
+#if !defined(CRT_TASK_NOTIFICATION_EVENTS)
+			  hFlags(nullptr),
+#ifdef CRT_TIMER_DIRECT_ISR_DELIVERY
+			  isrPendingBits(0),
+#endif
+#endif
 			  prev_stack_hwm(0)
 		{
+#if !defined(CRT_TASK_NOTIFICATION_EVENTS)
 		    hFlags = osEventFlagsNew(nullptr);
 		    assert(hFlags != nullptr);
+#endif
 		}
 
         void start()
@@ -72,7 +101,14 @@ namespace crt
 
         uint32_t queryBitNumber(Waitable* pWaitable)
         {
-            assert(nofWaitables < 24);
+            assert(nofWaitables < MAX_NOF_WAITABLES); // see CRT_MAX_NOF_WAITABLES in crt_Config.h.
+#ifdef CRT_MAX_NOF_WAITABLES
+            if (pWaitable->getType() == WaitableType::wt_Queue)
+            {
+            	arQueuesWords[nofWaitables / 32] |= (1u << (nofWaitables % 32));
+            }
+            return nofWaitables++;
+#endif
             switch (pWaitable->getType())
             {
             case WaitableType::wt_Queue:
@@ -111,7 +147,63 @@ namespace crt
 //            }
 //        }
 //
+#if defined(CRT_TASK_NOTIFICATION_EVENTS)
+        // Task notification events (see crt_Config.h): the bits are or-ed in the notification value
+        // of the task, which wakes it if it waits. From an ISR, that is direct as well:
+        // no FreeRTOS timer service is involved.
         inline void setEventBits(const uint32_t uxBitsToSet)
+        {
+        	assert(taskHandle != nullptr); // the task must be started first.
+        	if (__get_IPSR() != 0U)
+        	{
+        		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        		xTaskNotifyFromISR((TaskHandle_t)taskHandle, uxBitsToSet, eSetBits, &xHigherPriorityTaskWoken);
+        		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+        	}
+        	else
+        	{
+        		setEventFlags(uxBitsToSet);
+        	}
+        }
+#elif defined(CRT_TIMER_DIRECT_ISR_DELIVERY)
+        // Direct ISR delivery (see crt_Config.h): from an ISR, the bits are collected in
+        // isrPendingBits and the task is woken with a direct-to-task notification.
+        // osEventFlagsSet is not used from an ISR: that would defer it via the FreeRTOS timer service.
+        // The task itself moves the collected bits to its event flags, before checking them.
+        // From a task, the bits are set directly, and the task is notified as well.
+        inline void setEventBits(const uint32_t uxBitsToSet)
+        {
+        	if (__get_IPSR() != 0U)
+        	{
+        		UBaseType_t savedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+        		isrPendingBits |= uxBitsToSet;
+        		taskEXIT_CRITICAL_FROM_ISR(savedInterruptStatus);
+
+        		BaseType_t xHigherPriorityTaskWoken = pdFALSE;
+        		vTaskNotifyGiveFromISR((TaskHandle_t)taskHandle, &xHigherPriorityTaskWoken);
+        		portYIELD_FROM_ISR(xHigherPriorityTaskWoken);
+        	}
+        	else
+        	{
+        		setEventFlags(uxBitsToSet);
+        		xTaskNotifyGive((TaskHandle_t)taskHandle);
+        	}
+        }
+#else
+        inline void setEventBits(const uint32_t uxBitsToSet)
+        {
+        	setEventFlags(uxBitsToSet);
+        }
+#endif
+
+	private:
+#if defined(CRT_TASK_NOTIFICATION_EVENTS)
+        inline void setEventFlags(const uint32_t uxBitsToSet)
+        {
+        	xTaskNotify((TaskHandle_t)taskHandle, uxBitsToSet, eSetBits); // (eSetBits can't fail)
+        }
+#else
+        inline void setEventFlags(const uint32_t uxBitsToSet)
         {
         	// Should be safe to call from ISR as well, in CMSIS-2.
         	uint32_t error = osEventFlagsSet(hFlags,uxBitsToSet);
@@ -165,10 +257,318 @@ namespace crt
 //        	  osStatusReserved          = 0x7FFFFFFF  ///< Prevents enum down-size compiler optimization.
 //        	} osStatus_t;
         }
+#endif
+
+#if defined(CRT_TIMER_DIRECT_ISR_DELIVERY) && !defined(CRT_TASK_NOTIFICATION_EVENTS)
+        // Moves the bits set from ISRs to the event flags (task context: no timer service involved).
+        inline void absorbIsrPendingBits()
+        {
+        	taskENTER_CRITICAL();
+        	uint32_t bits = isrPendingBits;
+        	isrPendingBits = 0;
+        	taskEXIT_CRITICAL();
+        	if (bits != 0) setEventFlags(bits);
+        }
+#endif
 
+        // The ticks left of a timeout that started at startTick (osWaitForever stays osWaitForever).
+        // Returns false if it has expired.
+        inline static bool getRemainingTicks(uint32_t startTick, uint32_t timeout, uint32_t& remainingTicks)
+        {
+        	if (timeout == osWaitForever)
+        	{
+        		remainingTicks = osWaitForever;
+        		return true;
+        	}
+        	uint32_t elapsedTicks = osKernelGetTickCount() - startTick;
+        	if (elapsedTicks >= timeout) return false;
+        	remainingTicks = timeout - elapsedTicks;
+        	return true;
+        }
+
+        // osEventFlagsWait on the own event flags.
+        // With direct ISR delivery, the task blocks on its notification instead, and checks again
+        // after each one. (a notification given before ulTaskNotifyTake is not lost: it counts)
+        // timeout: in ticks (0: don't wait, osWaitForever: no timeout). Returns osFlagsErrorTimeout
+        // (or osFlagsErrorResource, for 0) if the bits weren't set in time.
+        // With task notification events, the same semantics are built on the notification value:
+        // it is checked (and cleared) in a critical section, and the task blocks on the next
+        // notification if it isn't satisfied. (a notification given meanwhile is not lost: it is pending)
+        inline uint32_t waitEventFlags(uint32_t bitsToWaitFor, uint32_t options, uint32_t timeout)
+        {
+#if defined(CRT_TASK_NOTIFICATION_EVENTS)
+        	uint32_t startTick = osKernelGetTickCount();
+        	for (;;)
+        	{
+        		taskENTER_CRITICAL();
+        		uint32_t result = ulTaskNotifyValueClear((TaskHandle_t)taskHandle, 0); // (only reads it)
+        		bool bSatisfied = ((options & osFlagsWaitAll) != 0) ?
+        		                  ((result & bitsToWaitFor) == bitsToWaitFor) :
+        		                  ((result & bitsToWaitFor) != 0);
+        		if (bSatisfied && ((options & osFlagsNoClear) == 0))
+        		{
+        			ulTaskNotifyValueClear((TaskHandle_t)taskHandle, bitsToWaitFor);
+        		}
+        		taskEXIT_CRITICAL();
+
+        		if (bSatisfied) return result;
+        		if (timeout == 0) return osFlagsErrorResource;
+        		uint32_t remainingTicks;
+        		if (!getRemainingTicks(startTick, timeout, remainingTicks)) return osFlagsErrorTimeout;
+        		xTaskNotifyWait(0, 0, nullptr, remainingTicks);
+        	}
+#elif defined(CRT_TIMER_DIRECT_ISR_DELIVERY)
+        	uint32_t startTick = osKernelGetTickCount();
+        	for (;;)
+        	{
+        		absorbIsrPendingBits();
+        		uint32_t result = osEventFlagsWait(hFlags, bitsToWaitFor, options, 0);
+        		if (((result & osFlagsError) == 0) || (timeout == 0))
+        		{
+        			return result;
+        		}
+        		uint32_t remainingTicks;
+        		if (!getRemainingTicks(startTick, timeout, remainingTicks)) return osFlagsErrorTimeout;
+        		ulTaskNotifyTake(pdTRUE, remainingTicks);
+        	}
+#else
+        	return osEventFlagsWait(hFlags, bitsToWaitFor, options, timeout);
+#endif
+        }
+
+	public:
         inline void clearEventBits(const uint32_t uxBitsToClear)
         {
+#if defined(CRT_TASK_NOTIFICATION_EVENTS)
+        	assert(__get_IPSR() == 0U); // ulTaskNotifyValueClear has no FromISR variant.
+        	ulTaskNotifyValueClear((TaskHandle_t)taskHandle, uxBitsToClear);
+#else
+#ifdef CRT_TIMER_DIRECT_ISR_DELIVERY
+        	taskENTER_CRITICAL();
+        	isrPendingBits &= ~uxBitsToClear;
+        	taskEXIT_CRITICAL();
+#endif
             osEventFlagsClear(hFlags, uxBitsToClear);
+#endif
+        }
+
+#ifdef CRT_MAX_NOF_WAITABLES
+        // Two-level event mask (see crt_Config.h): arFiredWords holds the fired waitables, and
+        // the event bit of a group only wakes the task. The waits below check arFiredWords first,
+        // and block on the group bits otherwise: a waitable that fires meanwhile sets its group bit
+        // after its word bit, so it is never missed. (a stale group bit causes one extra check)
+
+        // Marks the waitable as fired (from tasks and ISRs).
+        inline void setFired(const Waitable& waitable)
+        {
+        	if (__get_IPSR() != 0U)
+        	{
+        		UBaseType_t savedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+        		arFiredWords[waitable.getGroupNumber()] |= waitable.getWordMask();
+        		taskEXIT_CRITICAL_FROM_ISR(savedInterruptStatus);
+        	}
+        	else
+        	{
+        		taskENTER_CRITICAL();
+        		arFiredWords[waitable.getGroupNumber()] |= waitable.getWordMask();
+        		taskEXIT_CRITICAL();
+        	}
+        	setEventBits(waitable.getBitMask());
+        }
+
+        // Queue readiness (see Queue): called by the queue in a critical section, when it becomes
+        // (non)empty. No kernel calls: the queue wakes the task with setEventBits itself.
+        inline void setQueueReady(const Waitable& queue, bool bReady)
+        {
+        	if (bReady) arFiredWords[queue.getGroupNumber()] |= queue.getWordMask();
+        	else        arFiredWords[queue.getGroupNumber()] &= ~queue.getWordMask();
+        }
+
+        // The group bit may stay set: that only causes an extra check at the next wait.
+        inline void clearFired(const Waitable& waitable)
+        {
+        	if (__get_IPSR() != 0U)
+        	{
+        		UBaseType_t savedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+        		arFiredWords[waitable.getGroupNumber()] &= ~waitable.getWordMask();
+        		taskEXIT_CRITICAL_FROM_ISR(savedInterruptStatus);
+        	}
+        	else
+        	{
+        		taskENTER_CRITICAL();
+        		arFiredWords[waitable.getGroupNumber()] &= ~waitable.getWordMask();
+        		taskEXIT_CRITICAL();
+        	}
+        }
+
+        // Wait for a single waitable.
+        inline void wait(Waitable& waitable)
+        {
+            waitAll(WaitableSet(waitable));
+        }
+
+        // WaitAll waits till ALL the specified waitables have fired.
+        // It automatically clears them, apart from the queues.
+        // So there's no need to check with hasFired.
+		inline void waitAll(const WaitableSet& waitables)
+		{
+			waitAll_ticks(waitables, osWaitForever);
+		}
+
+        // Use hasFired() to determine which one fired.
+        // It is possible that multiple waitables fired at the same time.
+        // For a clean design, stop after finding the first one using hasFired.
+        //
+        // Thus, it is advised always to process only the actions on a single event after a waitAny.
+		inline void waitAny(const WaitableSet& waitables)
+		{
+			waitAny_ticks(waitables, osWaitForever);
+		}
+
+		// The waits with a timeout (see the single event bit variants below).
+		inline bool wait_ticks(Waitable& waitable, uint32_t timeout_ticks)
+		{
+			return waitAll_ticks(WaitableSet(waitable), timeout_ticks);
+		}
+
+		inline bool wait_us(Waitable& waitable, uint64_t timeout_us)
+		{
+			return wait_ticks(waitable, microsecondsToTicks(timeout_us));
+		}
+
+		inline bool waitAll_us(const WaitableSet& waitables, uint64_t timeout_us)
+		{
+			return waitAll_ticks(waitables, microsecondsToTicks(timeout_us));
+		}
+
+		inline bool waitAny_us(const WaitableSet& waitables, uint64_t timeout_us)
+		{
+			return waitAny_ticks(waitables, microsecondsToTicks(timeout_us));
+		}
+
+		inline bool waitAll_ticks(const WaitableSet& waitables, uint32_t timeout_ticks)
+		{
+			uint32_t startTick = osKernelGetTickCount();
+			for (;;)
+			{
+				taskENTER_CRITICAL();
+				bool bAllFired = true;
+				for (uint32_t groups = waitables.groupMask; groups != 0; groups &= (groups - 1))
+				{
+					uint32_t group = (uint32_t)__builtin_ctz(groups);
+					bAllFired &= ((arFiredWords[group] & waitables.arWords[group]) == waitables.arWords[group]);
+				}
+				if (bAllFired)
+				{
+					for (uint32_t groups = waitables.groupMask; groups != 0; groups &= (groups - 1))
+					{
+						uint32_t group = (uint32_t)__builtin_ctz(groups);
+						arFiredWords[group] &= ~(waitables.arWords[group] & ~arQueuesWords[group]);
+					}
+				}
+				taskEXIT_CRITICAL();
+
+				if (bAllFired)
+				{
+					latestFired = waitables;
+					latestResult = waitables.groupMask;
+					return true;
+				}
+				uint32_t remainingTicks;
+				if (!getRemainingTicks(startTick, timeout_ticks, remainingTicks))
+				{
+					latestFired = WaitableSet();
+					latestResult = 0;
+					return false;
+				}
+				waitEventFlags(waitables.groupMask, osFlagsWaitAny, remainingTicks);
+			}
+		}
+
+		inline bool waitAny_ticks(const WaitableSet& waitables, uint32_t timeout_ticks)
+		{
+			uint32_t startTick = osKernelGetTickCount();
+			while (!isAnySet(waitables))
+			{
+				uint32_t remainingTicks;
+				if (!getRemainingTicks(startTick, timeout_ticks, remainingTicks)) return false; // (latestFired is empty)
+				waitEventFlags(waitables.groupMask, osFlagsWaitAny, remainingTicks);
+			}
+			return true;
+		}
+
+		inline bool hasFired(Waitable& waitable)
+		{
+			bool result = latestFired.contains(waitable);
+            if (result && (waitable.getType() != WaitableType::wt_Queue))
+            {
+                // "Manually" Clear, except for a queue: only a read() may consume the event that signals that there's someting in the queue.
+                clearFired(waitable);
+            }
+            return result;
+		}
+
+		// Peek if the waitable has fired without resetting it and without waiting for it.
+        inline bool isSet(Waitable& waitable)
+        {
+        	return (arFiredWords[waitable.getGroupNumber()] & waitable.getWordMask()) != 0;
+        }
+
+        // The function below can be used to peek if the waitables have fired,
+        // without resetting them or waiting for them.
+        inline bool isAllSet(const WaitableSet& waitables)
+        {
+        	bool bAllFired = true;
+        	taskENTER_CRITICAL();
+			for (uint32_t groups = waitables.groupMask; groups != 0; groups &= (groups - 1))
+			{
+				uint32_t group = (uint32_t)__builtin_ctz(groups);
+				bAllFired &= ((arFiredWords[group] & waitables.arWords[group]) == waitables.arWords[group]);
+			}
+        	taskEXIT_CRITICAL();
+        	return bAllFired;
+        }
+
+        // The function below can be used to peek if any waitables have fired,
+        // without resetting them or waiting for them.
+        // You could test which one afterward, using the function hasFired.
+        // Only the groups in the set are visited (lowest first, with count trailing zeros).
+        inline bool isAnySet(const WaitableSet& waitables)
+        {
+        	latestFired = WaitableSet();
+        	taskENTER_CRITICAL();
+			for (uint32_t groups = waitables.groupMask; groups != 0; groups &= (groups - 1))
+			{
+				uint32_t group = (uint32_t)__builtin_ctz(groups);
+				uint32_t fired = arFiredWords[group] & waitables.arWords[group];
+				if (fired != 0)
+				{
+					latestFired.arWords[group] = fired;
+					latestFired.groupMask |= (1u << group);
+				}
+			}
+        	taskEXIT_CRITICAL();
+        	latestResult = latestFired.groupMask;
+        	return !latestFired.isEmpty();
+        }
+#else
+        inline void setFired(const Waitable& waitable)
+        {
+        	setEventBits(waitable.getBitMask());
+        }
+
+        inline void clearFired(const Waitable& waitable)
+        {
+        	clearEventBits(waitable.getBitMask());
+        }
+
+        // Queue readiness (see Queue): called by the queue in a critical section, when it becomes
+        // (non)empty. The waits check queuesReady, instead of keeping the event bit of a queue set
+        // as long as it holds messages. No kernel calls: the queue wakes the task with setEventBits itself.
+        inline void setQueueReady(const Waitable& queue, bool bReady)
+        {
+        	if (bReady) queuesReady |= queue.getBitMask();
+        	else        queuesReady &= ~queue.getBitMask();
         }
 
         // Wait for a single waitable.
@@ -182,14 +582,7 @@ namespace crt
         // So there's no need to check with hasFired.
 		inline void waitAll(uint32_t bitsToWaitFor)
 		{
-			latestResult = osEventFlagsWait(
-				hFlags,
-				bitsToWaitFor,
-				osFlagsWaitAll,
-				osWaitForever); // xTicksToWait)
-
-            // Actually, we didn't want to clear the queue bits, so let's repair that:
-            setEventBits(queuesMask & latestResult);
+			waitAll_ticks(bitsToWaitFor, osWaitForever);
 		}
 
 		// return value: the bits that were set at the time of firing.
@@ -200,21 +593,95 @@ namespace crt
         // Thus, it is advised always to process only the actions on a single event after a waitAny.
 		inline void waitAny(uint32_t bitsToWaitFor)
 		{
-			latestResult = osEventFlagsWait(
-				hFlags,
-				bitsToWaitFor,
-				osFlagsWaitAny | osFlagsNoClear,
-				osWaitForever); // xTicksToWait)
+			waitAny_ticks(bitsToWaitFor, osWaitForever);
+		}
+
+		// The waits with a timeout: they return false if the waitables didn't fire in time
+		// (hasFired is false for all of them then). The timeout is the native blocking timeout of the
+		// kernel, so no Timer (and no hardware timer interrupt) is involved.
+		// _ticks: in FreeRTOS ticks. _us: rounded up to whole ticks.
+		inline bool wait_ticks(Waitable& waitable, uint32_t timeout_ticks)
+		{
+			return waitAll_ticks(waitable.getBitMask(), timeout_ticks);
+		}
+
+		inline bool wait_us(Waitable& waitable, uint64_t timeout_us)
+		{
+			return wait_ticks(waitable, microsecondsToTicks(timeout_us));
+		}
+
+		inline bool waitAll_us(uint32_t bitsToWaitFor, uint64_t timeout_us)
+		{
+			return waitAll_ticks(bitsToWaitFor, microsecondsToTicks(timeout_us));
+		}
+
+		inline bool waitAny_us(uint32_t bitsToWaitFor, uint64_t timeout_us)
+		{
+			return waitAny_ticks(bitsToWaitFor, microsecondsToTicks(timeout_us));
+		}
+
+		// The queues are ready as long as they hold messages (see setQueueReady): they are checked
+		// first, without kernel calls. The event bit of a queue only wakes the task.
+		inline bool waitAll_ticks(uint32_t bitsToWaitFor, uint32_t timeout_ticks)
+		{
+			uint32_t queueBits = bitsToWaitFor & queuesMask;
+			uint32_t otherBits = bitsToWaitFor & ~queuesMask;
+			uint32_t startTick = osKernelGetTickCount();
+
+			for (uint32_t missingQueues = queueBits & ~queuesReady; missingQueues != 0;
+			     missingQueues = queueBits & ~queuesReady)
+			{
+				// (consumes the event bits of these queues)
+				uint32_t result = waitEventFlags(missingQueues, osFlagsWaitAny, getTicksLeft(startTick, timeout_ticks));
+				if ((result & osFlagsError) != 0) return timedOut();
+			}
+
+			latestResult = queueBits;
+			if (otherBits != 0)
+			{
+				uint32_t result = waitEventFlags(otherBits, osFlagsWaitAll, getTicksLeft(startTick, timeout_ticks));
+				if ((result & osFlagsError) != 0) return timedOut();
+				latestResult |= (result & ~queuesMask);
+			}
+			return true;
+		}
+
+		inline bool waitAny_ticks(uint32_t bitsToWaitFor, uint32_t timeout_ticks)
+		{
+			uint32_t queueBits = bitsToWaitFor & queuesMask;
+			uint32_t otherBits = bitsToWaitFor & ~queuesMask;
+			uint32_t startTick = osKernelGetTickCount();
+
+			for (;;)
+			{
+				uint32_t readyQueues = queueBits & queuesReady;
+				if (readyQueues != 0)
+				{
+					// The other waitables that fired are reported as well (a peek, if there are any).
+					latestResult = readyQueues | ((otherBits != 0) ? peekEventFlags(otherBits) : 0);
+					return true;
+				}
+
+				uint32_t result = waitEventFlags(bitsToWaitFor, osFlagsWaitAny | osFlagsNoClear,
+				                                 getTicksLeft(startTick, timeout_ticks));
+				if ((result & osFlagsError) != 0) return timedOut();
+				if ((result & otherBits) != 0)
+				{
+					latestResult = (result & otherBits) | (queueBits & queuesReady);
+					return true;
+				}
+				clearEventBits(result & queueBits); // only event bits of queues: consume them, and check the queues again.
+			}
 		}
 
 		inline bool hasFired(Waitable& waitable)
 		{
             uint32_t bitmask = waitable.getBitMask();
 			bool result = ((latestResult & bitmask) != 0);
-            if (result)
+            if (result && ((bitmask & queuesMask) == 0))
             {
-                // "Manually" Clear, except if a queue is involved for a queue, only a read() may consume the event that signals that there's someting in the queue.
-                clearEventBits((~queuesMask) & bitmask);
+                // "Manually" Clear, except for a queue: only a read() may consume the event that signals that there's someting in the queue.
+                clearEventBits(bitmask);
             }
             return result;
 		}
@@ -229,13 +696,9 @@ namespace crt
         // without resetting them or waiting for them.
         inline bool isAllSet(uint32_t bitsToWaitFor)
         {
-			latestResult = osEventFlagsWait(
-				hFlags,
-				bitsToWaitFor,
-				osFlagsWaitAll | osFlagsNoClear,
-				0); // xTicksToWait)
-
-			return (bitsToWaitFor == latestResult);
+        	uint32_t otherBits = bitsToWaitFor & ~queuesMask;
+        	latestResult = (bitsToWaitFor & queuesReady) | ((otherBits != 0) ? peekEventFlags(otherBits) : 0);
+			return ((latestResult & bitsToWaitFor) == bitsToWaitFor);
         }
 
         // The function below can be used to peek if any waitables have fired,
@@ -243,20 +706,47 @@ namespace crt
         // You could test which one afterward, using the function hasFired.
         inline bool isAnySet(uint32_t bitsToWaitFor)
         {
-			latestResult = osEventFlagsWait(
-				hFlags,
-				bitsToWaitFor,
-				osFlagsWaitAny | osFlagsNoClear,
-				0); // xTicksToWait)
-
+        	uint32_t otherBits = bitsToWaitFor & ~queuesMask;
+        	latestResult = (bitsToWaitFor & queuesReady) | ((otherBits != 0) ? peekEventFlags(otherBits) : 0);
 			return ((bitsToWaitFor & latestResult) != 0);
         }
 
+	private:
+        // The bits of bitsToPeek that are set (without clearing them or waiting).
+        inline uint32_t peekEventFlags(uint32_t bitsToPeek)
+        {
+        	uint32_t result = waitEventFlags(bitsToPeek, osFlagsWaitAny | osFlagsNoClear, 0);
+        	return ((result & osFlagsError) != 0) ? 0 : (result & bitsToPeek);
+        }
+
+        inline bool timedOut()
+        {
+        	latestResult = 0; // (hasFired is false for all waitables)
+        	return false;
+        }
+
+        // The ticks left of a timeout (0 once it has expired: then a wait only checks).
+        inline static uint32_t getTicksLeft(uint32_t startTick, uint32_t timeout)
+        {
+        	uint32_t remainingTicks;
+        	return getRemainingTicks(startTick, timeout, remainingTicks) ? remainingTicks : 0;
+        }
+
+	public:
+#endif
+
 		inline const char* getName()
 		{
 			return taskName;
 		}
 
+		// Rounded up to whole ticks. (as with any FreeRTOS timeout, the first tick may be a partial one)
+		inline static uint32_t microsecondsToTicks(uint64_t duration_us)
+		{
+			uint64_t ticks = (duration_us * configTICK_RATE_HZ + 999999) / 1000000;
+			return (ticks >= osWaitForever) ? (osWaitForever - 1) : (uint32_t)ticks;
+		}
+
 		// Next construct allows the main thread of the task to be run in a non-static function.
 		// That way, we can easily create multiple task objects from the same class.
 		static void staticMain(void *pParam)
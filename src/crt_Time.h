@@ -12,24 +12,62 @@ extern "C" {
 #include <cassert>
 
 #include "stmCycleCounter.h"
+#include "crt_Reciprocal64.h"
+#include "crt_Config.h"
 #include "crt_Task.h"
 
+#ifdef CRT_TIME_SOURCE_TIM5
+extern "C" {
+	#include "stmHwTimer5.h"
+}
+#endif
+
 namespace crt
 {
+	// Time counts "cycles" of its time source since startup, as a 64 bit number:
+	// - Default: the DWT cycle counter of the cpu (at SystemCoreClock). It is only 32 bits,
+	//   so the Time task adds it to a 64 bit total before it overflows.
+	// - CRT_TIME_SOURCE_TIM5 (crt_Config.h): timer5 at the APB1 timer clock, extended to
+	//   64 bits by its overflow interrupt. No task needed: saves its stack and its wakeups.
+	// getCountFrequency returns the amount of counts per second.
+	//
 	// Deze versie (itt de obs versie) maakt gebruik van een sequence counter
     // ipv taskEnterCritical, omdat dat sneller zou moeten zijn.
 	// Dat blijkt echter niet
-	class Time : public Task
+	class Time
+#ifndef CRT_TIME_SOURCE_TIM5
+	: public Task
+#endif
 	{
 	private:
+#ifndef CRT_TIME_SOURCE_TIM5
 		volatile uint64_t total;
+		volatile uint32_t lastCycleCount;	// DWT count at the latest update of total.
 		volatile uint32_t msPerCountOverflowCheck;
 
 		volatile uint32_t seq;
+#endif
+
+		// Conversions from counts divide by the count frequency. With a precomputed reciprocal,
+		// that is a multiply and a shift. Double buffered: recomputed in the spare one when
+		// the frequency has changed, then the pointer is switched. (a reader always sees a complete one)
+		Reciprocal64 arClockReciprocal[2];
+		const Reciprocal64* volatile pClockReciprocal;
 
 	public:
+#ifdef CRT_TIME_SOURCE_TIM5
+		Time() : arClockReciprocal{}, pClockReciprocal(&arClockReciprocal[0])
+		{
+			timer5_init();
+
+			startCycleCount(); // The DWT cycle counter is still handy for short measurements.
+
+			instance(this); // initialize the static _pInstance variable in the function instance().
+		}
+#else
 		Time(const char *taskName, osPriority_t taskPriority, unsigned int taskSizeBytes) :
-		Task(taskName, taskPriority, taskSizeBytes), total(0),msPerCountOverflowCheck(0),seq(0)
+		Task(taskName, taskPriority, taskSizeBytes), total(0),lastCycleCount(0),msPerCountOverflowCheck(0),seq(0),
+		arClockReciprocal{}, pClockReciprocal(&arClockReciprocal[0])
 		{
 			assert(configTICK_RATE_HZ == 1000); // in FreeRTOSConfig.h. Makes sure that osDelay(1) = 1ms.
 
@@ -43,6 +81,7 @@ namespace crt
 
 			start();
 		}
+#endif
 
 		// The function instance can be used to both initialize
 		// and to query it.
@@ -66,15 +105,24 @@ namespace crt
 			return _pInstance;
 		}
 
+		// Counts of the time source since startup (see getCountFrequency).
 		static inline uint64_t getTotalCycleCount()
 		{
 			return Time::instance()->getTotalCycleCount_impl();
 		}
 
+		// Counts per second of getTotalCycleCount.
+		static inline uint32_t getCountFrequency()
+		{
+			return getCountFrequency_impl();
+		}
+
+#ifndef CRT_TIME_SOURCE_TIM5
 		static inline void updateCycleCount()
 		{
 			Time::instance()->updateCycleCount_impl();
 		}
+#endif
 
 		static inline uint64_t getTimeSeconds()
 		{
@@ -91,31 +139,89 @@ namespace crt
 			return Time::instance()->getTimeMicroseconds_impl();
 		}
 
+		// Conversion of an amount of cycles to microseconds (rounded down).
+		static inline uint64_t cyclesToMicroseconds(uint64_t cycles)
+		{
+			return Time::instance()->getClockReciprocal().mulDiv(cycles, 1000000);
+		}
+
 	private:
 
-		// Bij 86Mhz clockspeed en compiler-optimization UIT, kost
-		// onderstaande functie ongeveer 5us op een 401 blackpill.
+		// Bij 86Mhz clockspeed en compiler-optimization UIT, kostte
+		// onderstaande functie ongeveer 5us op een 401 blackpill (met 64 bit deling).
+		// Nu: vermenigvuldigen en schuiven (zie crt_Reciprocal64.h).
+		// Exact, en zonder overflow van cycles * 1000000 (na ruim een dag bij 168MHz).
 		inline uint64_t getTimeMicroseconds_impl()
 		{
-			return getTotalCycleCount_impl() * 1000000 / uint64_t(SystemCoreClock);
+			return getClockReciprocal().mulDiv(getTotalCycleCount_impl(), 1000000);
 		}
 
 		inline uint64_t getTimeMilliseconds_impl()
 		{
-			return getTotalCycleCount_impl() * 1000 / uint64_t(SystemCoreClock);
+			return getClockReciprocal().mulDiv(getTotalCycleCount_impl(), 1000);
 		}
 
 		inline uint64_t getTimeSeconds_impl()
 		{
-			return (getTotalCycleCount_impl() / SystemCoreClock);
+			return getClockReciprocal().divide(getTotalCycleCount_impl());
 		}
 
+		static inline uint32_t getCountFrequency_impl()
+		{
+#ifdef CRT_TIME_SOURCE_TIM5
+			return timer5_get_frequency();
+#else
+			return SystemCoreClock;
+#endif
+		}
+
+		inline const Reciprocal64& getClockReciprocal()
+		{
+			const Reciprocal64* pReciprocal = pClockReciprocal;
+			if (pReciprocal->getDivisor() != (uint64_t)getCountFrequency_impl())
+			{
+				pReciprocal = updateClockReciprocal();
+			}
+			return *pReciprocal;
+		}
+
+		// Only when the count frequency has changed (and the first time).
+		// Can be called from a task or an ISR: the FROM_ISR variant only masks interrupts via BASEPRI.
+		const Reciprocal64* updateClockReciprocal()
+		{
+			UBaseType_t savedInterruptStatus = taskENTER_CRITICAL_FROM_ISR();
+			const Reciprocal64* pReciprocal = pClockReciprocal;
+			uint32_t frequency = getCountFrequency_impl();
+			if (pReciprocal->getDivisor() != (uint64_t)frequency)
+			{
+				Reciprocal64* pSpare = (pReciprocal == &arClockReciprocal[0]) ? &arClockReciprocal[1] : &arClockReciprocal[0];
+				pSpare->init(frequency);
+				pClockReciprocal = pSpare;
+				pReciprocal = pSpare;
+			}
+			taskEXIT_CRITICAL_FROM_ISR(savedInterruptStatus);
+			return pReciprocal;
+		}
+
+#ifdef CRT_TIME_SOURCE_TIM5
+		inline uint64_t getTotalCycleCount_impl()
+		{
+			return timer5_get_count64();
+		}
+#else
 		inline void updateCycleCount_impl()
 		{
+			// The counter is not reset anymore (that lost the cycles between reading and resetting).
+			// Only the cycles since the previous update are added. (unsigned: correct across its wrap)
+			// Critical section: an ISR (f.e. of Timers) that reads the time while seq is odd,
+			// would otherwise spin forever.
+			taskENTER_CRITICAL();
 			seq++; // seq becomes odd
-			total += getCycleCount(); 	// aggregate content of cyclecount to total.
-			resetCycleCount();			// reset cyclecount naar 0.
+			uint32_t cycleCount = getCycleCount();
+			total += (uint32_t)(cycleCount - lastCycleCount); 	// aggregate content of cyclecount to total.
+			lastCycleCount = cycleCount;
 			seq++; // seq becomes even again.
+			taskEXIT_CRITICAL();
 		}
 
 		inline uint64_t getTotalCycleCount_impl()
@@ -125,7 +231,7 @@ namespace crt
 		        uint32_t startSeq = seq;                 // 1) lees seq
 		        if (startSeq & 1u) continue;             //    odd = update bezig → opnieuw proberen
 
-		        uint64_t totalCycleCount = total + getCycleCount();    // 2) sample de teller
+		        uint64_t totalCycleCount = total + (uint32_t)(getCycleCount() - lastCycleCount);    // 2) sample de teller
 
 		        if (seq == startSeq)                     // 3) consistent? (niet veranderd én even)
 		            return totalCycleCount;                            //    ja → klaar, anders opnieuw
@@ -144,5 +250,6 @@ namespace crt
 				osDelay(msPerCountOverflowCheck);
 			}
 		}
+#endif
 	}; // end class StmTimers
 }; // end namespace crt
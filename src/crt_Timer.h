@@ -20,15 +20,12 @@ namespace crt
 	struct TimerCallBackInfo
 	{
 		Timer* pTimer;
-		uint32_t bitMask;
 
-		// bitmask is set by calling timer.setBitMask from Waitables during Task initialisation.
-		TimerCallBackInfo() : pTimer(nullptr), bitMask(0)
+		TimerCallBackInfo() : pTimer(nullptr)
 		{}
-		void init(Timer* pTimer, uint32_t bitMask)
+		void init(Timer* pTimer)
 		{
 			this->pTimer = pTimer;
-			this->bitMask = bitMask;
 		}
 	};
 
@@ -43,41 +40,29 @@ namespace crt
         Task* pTask;
 
 		bool bPeriodic;				// set to true if this Timer should auto-restart after firing.
-													   // Hw timer2 (which we are using now) is 32 bit.
-													   // For times larger than 1<<32 in us, chopup is needed.
-													   // you could temporarily set this to a lower value to test chopup
-													   // without waiting very long.
-		uint32_t maxHwTime = (uint32_t)((((uint64_t)1)<<32/*bits of used timer, timer2*/)-1);
-
-		// Everything used from both freertos task and ISR needs to be volatile.
-		volatile bool bLongTimeChoppingActive;	// In such a case, this bool is true.
-		volatile uint64_t totalLongTime_us;	    // .. and totalLongTime_us reflects the total time to wait.
-		volatile uint64_t currentlyWaiting_us;	// .. while currentlyWaiting_us reflects the time that the currently
-												// activated hardware timer is waiting.
-												// In case timer2 (32 bits is used), that is typically ((1<<32)-1).
-		volatile uint64_t waitTimeFiredSoFar_us; // Is increased by currentlyWaiting_us, as soon as hardware timer fires.
-										// Theoretically, a user could issue a new timer command after
-										// a rearm request was send to the relay. And before the relay could
-										// handle it. In that case, when the relay calls back, it can
-										// verify from longTimerRunId whether the current rearm request is
-										// not yet obsolete and can be discarded.
-		volatile uint32_t longTimerRunId; // id that separates subsequent longtimer sessions from one another.
-		                                  // It helps to indicate if a firing ISR should still be served.
-		                                  // (for which it needs the original member variables, so no new start or stops after starting the initial long timer start)
-		// obsolete:
-		//uint64_t chopUpCounter;
-		//uint64_t chopUpCount;		// large times, that don't fit in a uint32, need to be chopped up.
-									// In that case, chopUpCount > 1, which implies that the hwCounter
-									// is operated like a periodical counter. After counting chopUpCount
-									// periodical hw-fires, this Timer calls its client.
-									// If this Timer is non-periodical, it issues a stop to the hwtimer.
+		PeriodMode periodMode;			// only used if bPeriodic (see crt_Timers.h)
+		OverrunPolicy overrunPolicy;	// only used if bPeriodic and periodMode==FixedRate
+		uint32_t slack_us;				// the timer may fire up to slack_us late (see crt_Timers.h)
+
+		// Durations of any length (64 bits of microseconds) are handled by Timers itself:
+		// it keeps the deadlines in 64 bits, and rearms the hardware timer when a deadline
+		// lies beyond its range. So no chopping is needed here.
+#ifdef CRT_TIMER_DIRECT_ISR_DELIVERY
+		bool bDirectDelivery;	// false: deliver fires via LongTimerRelay (f.e. to compare the latency)
+#endif
+		volatile uint32_t runId; // Increased at every start and stop. A fire that is relayed via LongTimerRelay,
+		                         // carries the runId of the ISR. If a new start or stop came in between,
+		                         // the relayed fire is obsolete, and discarded.
 	public:
         Timer(Task* pTask):Waitable(WaitableType::wt_Timer), hTimer(Timers::TimerHandle_None), pTask(pTask),
-		bPeriodic(false), bLongTimeChoppingActive(false), totalLongTime_us(0), currentlyWaiting_us(0),
-		waitTimeFiredSoFar_us(0), longTimerRunId(0)
+		bPeriodic(false), periodMode(PeriodMode::FixedDelay), overrunPolicy(OverrunPolicy::Skip), slack_us(0),
+#ifdef CRT_TIMER_DIRECT_ISR_DELIVERY
+		bDirectDelivery(true),
+#endif
+		runId(0)
 		{
             Waitable::init(pTask->queryBitNumber(this));	// This will cause the bitmask of Waitable to be set properly.
-            timerCallBackInfo.init(this, Waitable::getBitMask());
+            timerCallBackInfo.init(this);
         }
 
         void createIfNeeded()
@@ -97,157 +82,130 @@ namespace crt
         inline void stop()
         {
 			if(!Timers::isValidTimerHandle(hTimer)) return;
-        	longTimerRunId++;
+        	runId++;
         	crt::Timers::stopTimer(hTimer);
-        	pTask->clearEventBits(bitMask);
-        	totalLongTime_us = 0;
-        	currentlyWaiting_us = 0;
-        	bLongTimeChoppingActive = false;
+        	pTask->clearFired(*this);
         }
 
-        // For quick tests of LongTimerRelay: ability to override maxHwTime with lower value.
-        inline void setMaxHwTime (uint32_t maxHwTime){this->maxHwTime = maxHwTime;}
-        inline uint32_t getMaxHwTime(){return maxHwTime;}
         inline TimerHandle getTimerHandle(){return hTimer;}
 
+#ifdef CRT_TIMER_DIRECT_ISR_DELIVERY
+        // Fires are delivered to the task directly from the timer interrupt (default),
+        // or via LongTimerRelay, like without CRT_TIMER_DIRECT_ISR_DELIVERY.
+        inline void setDirectDelivery(bool bDirectDelivery){this->bDirectDelivery = bDirectDelivery;}
+#endif
+
+        // Amount of periods that were missed (see OverrunPolicy), since start_periodic with PeriodMode::FixedRate.
+        inline uint32_t getOverrunCount()
+        {
+        	if(!Timers::isValidTimerHandle(hTimer)) return 0;
+        	return crt::Timers::getOverrunCount(hTimer);
+        }
+
 	private:
         inline void handleStart(uint64_t duration_us)
         {
-        	pTask->clearEventBits(bitMask); // .. from earlier run.
-
-        	totalLongTime_us = duration_us;
-
-        	currentlyWaiting_us = 0;
-        	waitTimeFiredSoFar_us = 0;
-            if(duration_us <= (uint64_t)maxHwTime)
-            {
-            	// Normal behaviour, no chopping required.
-            	bLongTimeChoppingActive = false;
-
-            	uint64_t overhead_compensation = 50;// TODO tweak penalty for clock etc. (calibrate using crt_TestTimer)
-
-            	currentlyWaiting_us = (duration_us<=overhead_compensation) ? 1 : duration_us-overhead_compensation;
-
-            	// Periodic hwTimer implies equal wait times, so only when no chopping and periodic.
-            	// (it avoids restart of hw timer and is a bit faster, in that case).
-            	crt::Timers::startTimer(hTimer, (uint32_t)currentlyWaiting_us, bPeriodic /*periodic*/);
-            }
-            else
-            {
-            	// chopping is required
-            	bLongTimeChoppingActive = true;
-				currentlyWaiting_us =  (uint64_t)maxHwTime; // maximizing wait time per chunk.
-
-				// Theoretically, until the last chunk, it could be hw periodic,
-				// saving a few microseconds. But for these long waits, that does not matter,
-				// and I prefer to keep the clarity of no auto-restarts for long timers.
-				crt::Timers::startTimer(hTimer, (uint32_t)currentlyWaiting_us, false /*hw periodic*/);
-            }
+        	TimerStartRequest request;
+        	prepareStart(duration_us, 0 /*offset_us*/, request);
+        	crt::Timers::startTimer(request.hTimer, request.duration_us, request.bPeriodic,
+        	                        request.periodMode, request.overrunPolicy, request.slack_us);
+        }
+
+        // Prepares the start request, with the settings of this Timer (bPeriodic, periodMode, ..).
+        inline void prepareStart(uint64_t duration_us, uint32_t offset_us, TimerStartRequest& request)
+        {
+        	pTask->clearFired(*this); // .. from earlier run.
+
+        	uint64_t overhead_compensation = crt::Timers::getTimerOverhead_us(); // measured at startup (see crt_TimerCalibration.h)
+        	if(bPeriodic && (periodMode == PeriodMode::FixedRate))
+        	{
+        		// The wake times are phase locked to the start: the overhead only delays
+        		// every fire by the same amount. Compensating would shorten the period.
+        		overhead_compensation = 0;
+        	}
+
+        	uint64_t waiting_us = (duration_us<=overhead_compensation) ? 1 : duration_us-overhead_compensation;
+
+        	// Periodic hwTimer implies equal wait times: it avoids a restart by the task, and is a bit faster.
+        	request = TimerStartRequest(hTimer, waiting_us, bPeriodic /*periodic*/,
+        	                            periodMode, overrunPolicy, slack_us, offset_us);
+        }
+
+        // Like start and start_periodic, but without starting: that is done by TimerGroup.
+        inline void prepare(uint64_t duration_us, bool bPeriodic, PeriodMode periodMode,
+                            OverrunPolicy overrunPolicy, uint32_t slack_us, uint32_t offset_us,
+                            TimerStartRequest& request)
+        {
+        	runId++;
+            createIfNeeded();
+            assert(duration_us >= Timers::minimumWaitTimeUs);                      // assert against bad design
+
+            this->bPeriodic = bPeriodic;
+            this->periodMode = periodMode;
+            this->overrunPolicy = overrunPolicy;
+            this->slack_us = slack_us;
+            prepareStart(duration_us, offset_us, request);
         }
 
 	public:
-        inline void start(uint64_t duration_us)
+        // slack_us: the timer may fire anywhere in [duration_us, duration_us + slack_us].
+        // Timers with overlapping windows share a hardware interrupt. Use it for timers
+        // that don't need precision (watchdog kicks, led blinks, housekeeping).
+        inline void start(uint64_t duration_us, uint32_t slack_us = 0)
         {
-        	longTimerRunId++;
+        	runId++;
             createIfNeeded();
             assert(duration_us >= Timers::minimumWaitTimeUs);                      // assert against bad design.. ah well on 16Mhz and without compiler optimization, it should be even 200us..
 
             bPeriodic = false;
+            this->slack_us = slack_us;
             handleStart(duration_us);
         }
 
-        inline void start_periodic(uint64_t period_us)
+        // PeriodMode::FixedDelay (default): the next period starts when the previous fire is handled.
+        // PeriodMode::FixedRate: the fires stay on the grid start + n*period (no drift).
+        //   If fires were missed (f.e. due to a long critical section), overrunPolicy decides
+        //   whether they are caught up or skipped. See getOverrunCount.
+        // slack_us: see start.
+        inline void start_periodic(uint64_t period_us,
+                                   PeriodMode periodMode = PeriodMode::FixedDelay,
+                                   OverrunPolicy overrunPolicy = OverrunPolicy::Skip,
+                                   uint32_t slack_us = 0)
         {
-        	longTimerRunId++;
+        	runId++;
             createIfNeeded();
             assert(period_us >= Timers::minimumWaitTimeUs);                        // assert against bad design
 
             bPeriodic = true;
+            this->periodMode = periodMode;
+            this->overrunPolicy = overrunPolicy;
+            this->slack_us = slack_us;
             handleStart(period_us);
         }
 
 		static void static_timer_callback(void* arg)
 		{
 			TimerCallBackInfo* pWCI = (TimerCallBackInfo*)arg;
-			pWCI->pTimer->timer_callback(pWCI->bitMask);
+			pWCI->pTimer->timer_callback();
 		}
 
-		// Actually, it does not rearm if it is finished.
-		// Theoretically, that case could be handled in timer_callback,
-		// such that the rearm relay is not needed.
-
-		// However, I like the simplicity of the current solution,
-		// and for these long waits, the few microseconds of the extra relay
-		// does not seem important.
-		void rearmToContinueLongTiming(uint32_t longTimerRunId_relayed)
+		inline void timer_callback()
 		{
-			if(longTimerRunId != longTimerRunId_relayed)
+#ifdef CRT_TIMER_DIRECT_ISR_DELIVERY
+			if(bDirectDelivery)
 			{
-				return; // the long timing that corresponded with this call was interrupted.
+				// Wakes the task directly, via a task notification (see Task::setEventBits).
+				// No run id check needed: the fire is handled synchronously with stop and start,
+				// and those clear the event bit.
+				pTask->setFired(*this);
+				return;
 			}
+#endif
+			// periodic hwTimer will go on. non-periodic hwTimer will stop. no action required.
+			// Set the eventbit of the client.
 
-			waitTimeFiredSoFar_us += currentlyWaiting_us;
-			uint64_t timeLeft = totalLongTime_us - waitTimeFiredSoFar_us;
-
-			if(timeLeft < Timers::minimumWaitTimeUs)
-			{
-				// Not enough time left for another hw interrupt.
-				// Consider it done.
-			    waitTimeFiredSoFar_us = totalLongTime_us;
-			    timeLeft = 0;
-			}
-
-			if(timeLeft == 0)
-			{
-				// Chopups finished, we may fire below.
-				// And we have to restart the process in case of periodic.
-				if(bPeriodic)
-				{
-					// restart again
-					start_periodic(totalLongTime_us);
-				}
-				else
-				{
-					bLongTimeChoppingActive = false; // oneshot finished.
-				}
-				// else no need to stop the timer, bLongTimeChoppingActive -> !bHwPeriodic
-				pTask->setEventBits(bitMask);
-			}
-			else
-			{
-				// Not ready yet.
-				if(timeLeft > (uint64_t)maxHwTime)
-				{
-					assert(currentlyWaiting_us == (uint64_t)maxHwTime);
-					// no need to change currentlyWaiting_us.
-					// simply restart the timer with current settings.
-					crt::Timers::startTimer(hTimer, (uint32_t)currentlyWaiting_us, false/*periodic*/);
-				}
-				else
-				{
-					// start timer for the remainder
-					currentlyWaiting_us = timeLeft;
-					crt::Timers::startTimer(hTimer, (uint32_t)currentlyWaiting_us, false/*periodic*/);
-				}
-			}
-		}
-
-		inline void timer_callback(uint32_t bitMask)
-		{
-			if(bLongTimeChoppingActive)
-			{
-				// Lange wacht → rearm via Relay
-				LongTimerRelay::requestRearmTimer(this, (uint32_t)longTimerRunId);
-			}
-			else
-			{
-				//no chopping. periodic hwTimer will go on. non-periodic hwTimer will stop. no action required.
-				// Set the eventbit of the client.
-
-				// korte/gewone fire → afleveren via Relay
-				LongTimerRelay::requestDeliver(this, (uint32_t)longTimerRunId);
-				//pTask->setEventBits(bitMask);   Geen directe setEventBits meer in ISR!
-			}
+			// fire → afleveren via Relay
+			LongTimerRelay::requestDeliver(this, (uint32_t)runId);
 
 
             // portYIELD_FROM_ISR(pdTRUE); No need to immmediately yield. Perhaps there are more timers that have fired,
@@ -268,7 +226,94 @@ namespace crt
 
 	private:
 		friend class LongTimerRelay;
+		template <size_t> friend class TimerGroup;
 		Task*     getOwnerTask() const { return pTask; }
-		uint32_t  getLongTimerRunId() const { return longTimerRunId; }
+		uint32_t  getRunId() const { return runId; }
 	};
+
+	// A TimerGroup starts a group of Timers at once (f.e. the channels of a multi-channel actuator):
+	// they share the same reference instant, and Timers inserts them in a single critical section
+	// and reprograms the hardware timer once (see Timers::startTimers).
+	// Per timer, an offset_us delays the first fire. For periodic timers, that gives staggered phases.
+	//
+	// Usage:
+	//   TimerGroup<8> group;	// member of the Task, like its Timers.
+	//   for (int i=0; i<8; i++) group.add_periodic(arTimer[i], 1000 /*period_us*/, i*125 /*offset_us*/);
+	//   group.start();	// restarts all, whenever called again.
+	template <size_t MAX_NOF_GROUP_TIMERS>
+	class TimerGroup
+	{
+	private:
+		struct Entry
+		{
+			Timer* pTimer;
+			uint64_t duration_us;
+			bool bPeriodic;
+			PeriodMode periodMode;
+			OverrunPolicy overrunPolicy;
+			uint32_t slack_us;
+			uint32_t offset_us;
+		};
+
+		Entry arEntries[MAX_NOF_GROUP_TIMERS];
+		TimerStartRequest arRequests[MAX_NOF_GROUP_TIMERS];
+		uint32_t nofEntries;
+
+	public:
+		TimerGroup() : arEntries{}, arRequests{}, nofEntries(0)
+		{}
+
+		// see Timer::start
+		inline void add(Timer& timer, uint64_t duration_us, uint32_t slack_us = 0, uint32_t offset_us = 0)
+		{
+			addEntry(Entry{&timer, duration_us, false, PeriodMode::FixedDelay, OverrunPolicy::Skip, slack_us, offset_us});
+		}
+
+		// see Timer::start_periodic
+		inline void add_periodic(Timer& timer, uint64_t period_us, uint32_t offset_us = 0,
+		                         PeriodMode periodMode = PeriodMode::FixedDelay,
+		                         OverrunPolicy overrunPolicy = OverrunPolicy::Skip,
+		                         uint32_t slack_us = 0)
+		{
+			addEntry(Entry{&timer, period_us, true, periodMode, overrunPolicy, slack_us, offset_us});
+		}
+
+		inline void start()
+		{
+			for (uint32_t i = 0; i < nofEntries; i++)
+			{
+				Entry& entry = arEntries[i];
+				entry.pTimer->prepare(entry.duration_us, entry.bPeriodic, entry.periodMode,
+				                      entry.overrunPolicy, entry.slack_us, entry.offset_us,
+				                      arRequests[i]);
+			}
+			crt::Timers::startTimers(arRequests, nofEntries);
+		}
+
+		inline void stop()
+		{
+			for (uint32_t i = 0; i < nofEntries; i++)
+			{
+				arEntries[i].pTimer->stop();
+			}
+		}
+
+		// Removes all timers from the group (it does not stop them).
+		inline void clear()
+		{
+			nofEntries = 0;
+		}
+
+		inline uint32_t getNofTimers()
+		{
+			return nofEntries;
+		}
+
+	private:
+		inline void addEntry(const Entry& entry)
+		{
+			assert(nofEntries < MAX_NOF_GROUP_TIMERS);
+			arEntries[nofEntries++] = entry;
+		}
+	}; // end class TimerGroup
 };
@@ -13,21 +13,41 @@ extern "C" {
 }
 
 //#include "crt_CleanRTOS.h"
+#include "crt_Config.h"
 
 namespace crt
 {
 	enum class WaitableType { wt_None, wt_Queue, wt_Flag, wt_Timer };
 
+#ifdef CRT_MAX_NOF_WAITABLES
+	// Two-level event mask (see crt_Config.h): waitable n is bit (n % 32) of word (n / 32)
+	// of a software bitmap of its task. Every word is summarized by one event bit: the "group bit".
+	constexpr uint32_t MAX_NOF_WAITABLES = CRT_MAX_NOF_WAITABLES;
+	constexpr uint32_t NOF_WAITABLE_GROUPS = (MAX_NOF_WAITABLES + 31) / 32;
+	static_assert(NOF_WAITABLE_GROUPS <= 24, "CRT_MAX_NOF_WAITABLES can be 768 at most (24 event bits of 32 waitables)");
+
+	class WaitableSet;
+#else
+	constexpr uint32_t MAX_NOF_WAITABLES = 24; // a single event bit each.
+#endif
+
 	class Waitable
 	{
 	protected:
 		uint32_t		bitNumber;
-		uint32_t		bitMask;
+		uint32_t		bitMask;	// with CRT_MAX_NOF_WAITABLES: the group bit.
+#ifdef CRT_MAX_NOF_WAITABLES
+		uint32_t		wordMask;	// its bit in the word of its group.
+#endif
 		static const uint32_t	bitMaskUndefined = 0;
 		WaitableType    waitableType = WaitableType::wt_None;
 
 	public:
-		Waitable(WaitableType waitableType) :bitNumber(0), bitMask(bitMaskUndefined), waitableType(waitableType)
+		Waitable(WaitableType waitableType) :bitNumber(0), bitMask(bitMaskUndefined),
+#ifdef CRT_MAX_NOF_WAITABLES
+			wordMask(0),
+#endif
+			waitableType(waitableType)
 		{
 		}
 
@@ -39,6 +59,22 @@ namespace crt
 		// solution:
 		inline WaitableType getType() const {return waitableType;}
 
+#ifdef CRT_MAX_NOF_WAITABLES
+		void init(uint32_t nBitNumber)
+		{
+			this->bitNumber = nBitNumber;
+			this->bitMask = 1 << (nBitNumber / 32);
+			this->wordMask = 1 << (nBitNumber % 32);
+		}
+		inline uint32_t getBitNumber() const {return bitNumber;}
+		inline uint32_t getBitMask() const { return bitMask; }
+		inline uint32_t getGroupNumber() const { return bitNumber / 32; }
+		inline uint32_t getWordMask() const { return wordMask; }
+
+		// Combine waitables with +, f.e. waitAny(flagA + queueB + timerC).
+		// (not with | on getBitMask: that is the group bit only)
+		WaitableSet operator+(Waitable& other);
+#else
 		void init(uint32_t nBitNumber) { this->bitNumber = nBitNumber; this->bitMask = 1 << nBitNumber; }
 		inline uint32_t getBitNumber() const {return bitNumber;}
 		inline uint32_t getBitMask() const { return bitMask; }
@@ -57,5 +93,51 @@ namespace crt
         {
             return bitMask | other.getBitMask();
         }
+#endif
 	};
+
+#ifdef CRT_MAX_NOF_WAITABLES
+	// A set of waitables of a single task, for waitAny and waitAll: per group, the bits of its
+	// waitables, and the group bits of the groups that have any.
+	class WaitableSet
+	{
+	public:
+		uint32_t groupMask;
+		uint32_t arWords[NOF_WAITABLE_GROUPS];
+
+		WaitableSet() : groupMask(0), arWords{}
+		{
+		}
+
+		WaitableSet(const Waitable& waitable) : WaitableSet()
+		{
+			add(waitable);
+		}
+
+		inline void add(const Waitable& waitable)
+		{
+			groupMask |= waitable.getBitMask();
+			arWords[waitable.getGroupNumber()] |= waitable.getWordMask();
+		}
+
+		inline bool contains(const Waitable& waitable) const
+		{
+			return (arWords[waitable.getGroupNumber()] & waitable.getWordMask()) != 0;
+		}
+
+		inline bool isEmpty() const { return groupMask == 0; }
+
+		WaitableSet operator+(const Waitable& waitable) const
+		{
+			WaitableSet result = *this;
+			result.add(waitable);
+			return result;
+		}
+	};
+
+	inline WaitableSet Waitable::operator+(Waitable& other)
+	{
+		return WaitableSet(*this) + other;
+	}
+#endif
 };
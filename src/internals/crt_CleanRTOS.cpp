@@ -4,6 +4,7 @@
 #include "crt_CleanRTOS.h"
 #include <crt_Time.h>
 #include "crt_LongTimerRelay.h"
+#include "crt_TimerCalibration.h"
 
 extern "C" {
 	#include "cmsis_os2.h"
@@ -12,9 +13,17 @@ extern "C" {
 void crt::cleanRTOS_init()
 {
 	// crt::Time is the "watch", used to measured passed time (while not sleeping).
+#ifdef CRT_TIME_SOURCE_TIM5
+	static crt::Time time; // No task: timer5 and its overflow interrupt keep the time.
+#else
 	static crt::Time timeTask("stmTimeTask", osPriorityNormal /*priority*/, 2200 /*stackBytes*/);
+#endif
 	// From hereon, the StmTime singleton can be accessed via its static StmTime::instance() function.
 
-	// crt::LongTimerRelay helps to time-chunk-wise restart Timer objects to wait longer than otherwise possible.
+	// crt::LongTimerRelay delivers the fires of Timer objects to their tasks (see crt_LongTimerRelay.h).
 	static crt::LongTimerRelay longTimerRelayTask("longTimerRelayTask", osPriorityNormal /*priority*/, 2200 /*stackBytes*/);
+
+	// crt::TimerCalibration measures the overhead of the timers once, as soon as the scheduler has started,
+	// and stores it in crt::Timers. Then it exits. High priority: it should run before the other tasks.
+	static crt::TimerCalibration timerCalibrationTask("timerCalibrationTask", osPriorityHigh /*priority*/, 1024 /*stackBytes*/);
 }
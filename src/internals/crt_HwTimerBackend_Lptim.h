@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+
+#include "stmHwLptim1.h"
+
+namespace crt
+{
+	// Hardware timer backend for Timers_template: LPTIM1 (16 bits, on the 32.768kHz LSE),
+	// via stmHwLptim1. (for the interface, see crt_HwTimerBackend_Tim2.h)
+	//
+	// Unlike timer2, LPTIM1 keeps running in Stop modes (Stop2 on the STM32L4), and wakes the
+	// mcu from them. So Timers can keep timers alive while the mcu sleeps deeply.
+	// Timers keeps its time in LPTIM1 counts as well (bOwnTimeBase): the counter, extended with
+	// its wraps. (the time source of Time, timer5 or the DWT cycle counter, stops in Stop mode)
+	// The price: a resolution of about 30.5 us, a rearm at least every second for longer
+	// deadlines (maxDelta_us), and a wakeup every 2 seconds to count the wraps.
+	// Time itself (Time::getTotalCycleCount) still stops in Stop mode.
+	//
+	// Select it with CRT_TIMER_BACKEND_LPTIM in crt_Config.h.
+	class HwTimerBackend_Lptim
+	{
+	public:
+		static constexpr bool bFreeRunning = true;
+		static constexpr uint32_t maxDelta_us = LPTIM1_MAX_DELTA_US;
+
+		static inline void init(TimerCallback callback, void* userData)
+		{
+			lptim1_init();
+			lptim1_set_callback(callback, userData); // fires and software triggers.
+		}
+
+		static inline void fireAfter_us(uint32_t delta_us) { lptim1_fire_after_us(delta_us); }
+		static inline void cancel() { lptim1_cancel(); }
+		static inline void pause()  {}
+		static inline void resume() {}
+
+		static constexpr bool bOwnTimeBase = true;
+		static inline uint64_t getTimeBaseCount() { return lptim1_get_count64(); }
+		static inline uint32_t getTimeBaseFrequency() { return LPTIM1_FREQUENCY_HZ; }
+
+		static inline void triggerSoftwareInterrupt() { lptim1_trigger_software_interrupt(); }
+	}; // end class HwTimerBackend_Lptim
+}; // end namespace crt
@@ -0,0 +1,89 @@
+#pragma once
+#include <cstdint>
+
+#include "crt_Config.h"
+#include "crt_Time.h"
+#include "stmHwTimer2.h"
+
+namespace crt
+{
+	// Hardware timer backend for Timers_template: timer2 (32 bits, 1MHz), via stmHwTimer2.
+	//
+	// A backend is a class with only static functions (it wraps a single hardware timer):
+	//   init(callback, userData)   the callback is called from the timer interrupt, at a fire and
+	//                              at a software trigger.
+	//   fireAfter_us(delta_us)     (re)programs the single deadline. delta_us <= maxDelta_us.
+	//                              0: as soon as possible.
+	//   cancel()                   no fire anymore (until the next fireAfter_us).
+	//   pause(), resume()          around manipulation of the timer queue by tasks, if !bFreeRunning.
+	//   getTimeBaseCount()         the time base of Timers: a 64 bit count, in counts of
+	//   getTimeBaseFrequency()     getTimeBaseFrequency() per second. Timers keeps all its times in it.
+	//   triggerSoftwareInterrupt() calls the callback from the timer interrupt, asap.
+	//                              (callable from tasks and ISRs, without masking interrupts)
+	// Constants:
+	//   bFreeRunning               true if the counter never stops: no pause and resume needed,
+	//                              and the deadline can be reprogrammed any time (required for
+	//                              CRT_TIMERS_COMMAND_QUEUE).
+	//   maxDelta_us                largest delta of fireAfter_us. Timers rearms for longer deadlines.
+	//   bOwnTimeBase               false: the time base is the cpu cycle count of Time.
+	//                              true: the counter of the hardware timer itself (f.e. because
+	//                              it keeps running in Stop modes, while Time stops).
+	//
+	// The timer interrupt must have a priority at which FreeRTOS FromISR functions may be called,
+	// and that is masked by the critical sections of FreeRTOS.
+	//
+	// See also crt_HwTimerBackend_Lptim.h. The backend is selected in crt_Config.h.
+	//
+	// If CRT_TIMER2_FREE_RUNNING is defined (crt_Config.h), the counter of timer2 runs freely and
+	// compare channel 1 is used for the deadline. Otherwise the counter is restarted for every deadline.
+	class HwTimerBackend_Tim2
+	{
+	public:
+#ifdef CRT_TIMER2_FREE_RUNNING
+		static constexpr bool bFreeRunning = true;
+		static constexpr uint32_t maxDelta_us = 0x7FFFFFFF; // compare window of timer2_fire_at_us: < 2^31.
+
+		static inline void init(TimerCallback callback, void* userData)
+		{
+			timer2_init_free_running();
+			timer2_set_compare_callback(TIMER2_CHANNEL_1, callback, userData);
+			timer2_set_software_callback(callback, userData);
+		}
+
+		static inline void fireAfter_us(uint32_t delta_us)
+		{
+			timer2_fire_at_us(TIMER2_CHANNEL_1, timer2_now() + delta_us); // delta 0: fires right away.
+		}
+
+		static inline void cancel() { timer2_cancel(TIMER2_CHANNEL_1); }
+		static inline void pause()  {}
+		static inline void resume() {}
+#else
+		static constexpr bool bFreeRunning = false;
+		static constexpr uint32_t maxDelta_us = 0xFFFFFFFF; // 32 bit counter of timer2.
+
+		static inline void init(TimerCallback callback, void* userData)
+		{
+			timer2_init();
+			timer2_set_callback(callback, userData);
+			timer2_set_software_callback(callback, userData);
+		}
+
+		static inline void fireAfter_us(uint32_t delta_us)
+		{
+			if (delta_us == 0) delta_us = 1;
+			timer2_fire_after_us(delta_us);
+		}
+
+		static inline void cancel() { timer2_pause(); }
+		static inline void pause()  { timer2_pause(); }
+		static inline void resume() { timer2_resume(); }
+#endif
+
+		static constexpr bool bOwnTimeBase = false;
+		static inline uint64_t getTimeBaseCount() { return Time::getTotalCycleCount(); }
+		static inline uint32_t getTimeBaseFrequency() { return Time::getCountFrequency(); }
+
+		static inline void triggerSoftwareInterrupt() { timer2_trigger_software_interrupt(); }
+	}; // end class HwTimerBackend_Tim2
+}; // end namespace crt
@@ -11,38 +11,22 @@ extern "C" {
 #include <cstdint>
 #include <cassert>
 
-#include "crt_Task.h"
-#include "crt_Queue.h"
+#include "crt_DeferredWork.h"
 
 namespace crt
 {
-   // Long timers need to rearm hw timers multiple times, before
-   // being able to fire to the client.
-   // For safety and reducing ISR service time,
-   // rearmament is done by this task, rather than
-   // (in a complex ISR proof way) in the ISR itself.
-
-   // Assumption for safe behaviour:
+   // Relays the fires of Timers from the timer ISR to task context, where the event bit of the
+   // owner task is set. (without CRT_TIMER_DIRECT_ISR_DELIVERY, or if direct delivery is switched off)
+   // Long timers no longer need it: Timers handles 64 bit deadlines itself.
+   // (the name stems from when long timers were rearmed chunk by chunk, from this task)
+   //
+   // It is a DeferredWork worker (see crt_DeferredWork.h): the timer ISR posts the delivery
+   // with the Timer as argument and its run id as payload.
 
 	class Timer; // forward declaration, to avoid mutual depency of header file inclusion.
 
-	enum class RelayAction : uint8_t { Rearm, DeliverOnly };
-
-	struct LongTimerRelayInfo
-	{
-	    Timer*    pTimer;
-	    uint32_t  longTimerRunId;
-	    RelayAction action;
-
-	    LongTimerRelayInfo() : pTimer(nullptr), longTimerRunId(0), action(RelayAction::Rearm) {}
-	    LongTimerRelayInfo(Timer* p, uint32_t runId, RelayAction a)
-	    : pTimer(p), longTimerRunId(runId), action(a) {}
-	};
-
-	class LongTimerRelay : public Task
+	class LongTimerRelay : public DeferredWork<16>
 	{
-		Queue<LongTimerRelayInfo, 10> queueLongTimersThatDesireRearm;
-
 	public:
 		LongTimerRelay(const char *taskName, osPriority_t taskPriority, unsigned int taskSizeBytes);
 
@@ -56,19 +40,10 @@ namespace crt
 		// being stopped or having finally fired. (pTimer must remain valid while Queued).
 		// This is automatically achieved when always preallocating all required timers
 		// and not destroying them - which is the advised way of embedded programming.
-		static void requestRearm(const LongTimerRelayInfo& pLongTimerRelayInfo);
-
-	    static inline void requestDeliver(Timer* t, uint32_t runId) {
-	        requestRearm(LongTimerRelayInfo{t, runId, RelayAction::DeliverOnly});
-	    }
-		// Lever meteen vanuit ISR. Geen relay-queue meer voor DeliverOnly.
-//		static void requestDeliver(Timer* t, uint32_t runId);
-
-	    static inline void requestRearmTimer(Timer* t, uint32_t runId) {
-	        requestRearm(LongTimerRelayInfo{t, runId, RelayAction::Rearm});
-	    }
+		// The fire is discarded if the timer was started or stopped again meanwhile (runId changed).
+		static void requestDeliver(Timer* pTimer, uint32_t runId);
 
 	private:
-		void main() override;
+		static void deliver(void* pTimer, uint32_t runId);
 	}; // end class LongTimerRelay
 }; // end namespace crt
@@ -0,0 +1,110 @@
+#pragma once
+#include <cstdint>
+#include <atomic>
+
+namespace crt
+{
+	// Bounded lock-free ring for multiple producers and a single consumer.
+	// Producers (tasks, or ISRs) never mask interrupts: a slot is claimed with a compare-and-swap
+	// (ldrex/strex on a Cortex-M), and published with the sequence number of its cell.
+	// (the bounded queue of Dmitry Vyukov, with a single consumer)
+	//
+	// A producer that is preempted between claiming and publishing its slot, holds up the
+	// consumer at that slot (tryPop returns false) until it has published it.
+	// So after a push, the producer should notify the consumer (f.e. pend its interrupt).
+	//
+	// No HAL or RTOS dependencies, so it can be tested on the host (see tests/MpscRing).
+	template <typename T, uint32_t SIZE>
+	class MpscRing
+	{
+		static_assert((SIZE >= 2) && ((SIZE & (SIZE - 1)) == 0), "SIZE must be a power of 2");
+
+	private:
+		struct Cell
+		{
+			std::atomic<uint32_t> sequence;	// pos: free for push at pos. pos+1: holds item of pos.
+			T item;
+		};
+
+		Cell arCells[SIZE];
+		std::atomic<uint32_t> pushPos;
+		std::atomic<uint32_t> popPos;	// only written by the consumer.
+
+	public:
+		MpscRing() : pushPos(0), popPos(0)
+		{
+			for (uint32_t i = 0; i < SIZE; i++)
+			{
+				arCells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+		}
+
+		// Returns false if the ring is full. ticket: the position of the item (see isPopped).
+		bool tryPush(const T& item, uint32_t& ticket)
+		{
+			uint32_t pos = pushPos.load(std::memory_order_relaxed);
+			Cell* pCell;
+			for (;;)
+			{
+				pCell = &arCells[pos & (SIZE - 1)];
+				uint32_t sequence = pCell->sequence.load(std::memory_order_acquire);
+				int32_t diff = (int32_t)(sequence - pos);
+				if (diff == 0)
+				{
+					// Free: claim it. On failure, pos is updated with the current pushPos.
+					if (pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+					{
+						break;
+					}
+				}
+				else if (diff < 0)
+				{
+					return false; // full: the consumer has not popped this cell yet.
+				}
+				else
+				{
+					pos = pushPos.load(std::memory_order_relaxed); // claimed by another producer.
+				}
+			}
+
+			pCell->item = item;
+			pCell->sequence.store(pos + 1, std::memory_order_release); // publish.
+			ticket = pos;
+			return true;
+		}
+
+		inline bool tryPush(const T& item)
+		{
+			uint32_t ticket;
+			return tryPush(item, ticket);
+		}
+
+		// Consumer only.
+		bool tryPop(T& item)
+		{
+			uint32_t pos = popPos.load(std::memory_order_relaxed);
+			Cell& cell = arCells[pos & (SIZE - 1)];
+			uint32_t sequence = cell.sequence.load(std::memory_order_acquire);
+			if ((int32_t)(sequence - (pos + 1)) < 0)
+			{
+				return false; // empty (or its producer has not published it yet).
+			}
+
+			item = cell.item;
+			cell.sequence.store(pos + SIZE, std::memory_order_release); // free for the next round.
+			popPos.store(pos + 1, std::memory_order_release);
+			return true;
+		}
+
+		// true if the item pushed with ticket has been popped.
+		inline bool isPopped(uint32_t ticket) const
+		{
+			return (int32_t)(popPos.load(std::memory_order_acquire) - ticket) > 0;
+		}
+
+		inline bool isEmpty() const
+		{
+			return popPos.load(std::memory_order_acquire) == pushPos.load(std::memory_order_acquire);
+		}
+	};
+}; // end namespace crt
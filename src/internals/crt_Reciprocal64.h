@@ -0,0 +1,130 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+
+namespace crt
+{
+	// Division by a runtime constant (f.e. SystemCoreClock) as a multiply and a shift.
+	// On a Cortex-M, a 64 bit division is a slow library call (there is no 64 bit divider),
+	// while a 64x64 bit multiply-high takes 4 umull's.
+	//
+	// divide(n) == floor(n / divisor), exactly, for every 64 bit n.
+	// (the unsigned 64 bit algorithm of libdivide, by ridiculous_fish)
+	// mulDiv(n, a) == floor(n * a / divisor), exactly, without overflow of n * a.
+	//
+	// init does a 128/64 division bit by bit: slow-ish, but only when the divisor changes.
+	// No HAL or RTOS dependencies, so it can be tested on the host (see tests/Reciprocal64).
+	class Reciprocal64
+	{
+	private:
+		uint64_t _magic;	// 0: divisor is a power of 2 (shift only).
+		uint64_t _divisor;
+		uint8_t  _shift;
+		bool     _bAdd;		// magic needs 65 bits: use the add variant.
+
+	public:
+		Reciprocal64() : _magic(0), _divisor(1), _shift(0), _bAdd(false)
+		{}
+
+		explicit Reciprocal64(uint64_t divisor) : Reciprocal64()
+		{
+			init(divisor);
+		}
+
+		void init(uint64_t divisor)
+		{
+			assert(divisor != 0);
+			_divisor = divisor;
+
+			uint32_t floorLog2 = 63 - (uint32_t)__builtin_clzll(divisor);
+			_shift = (uint8_t)floorLog2;
+			_bAdd  = false;
+
+			if ((divisor & (divisor - 1)) == 0)
+			{
+				_magic = 0;
+				return;
+			}
+
+			// 2^(64+floorLog2) / divisor. Fits in 64 bits, as divisor > 2^floorLog2.
+			uint64_t rem = 0;
+			uint64_t proposed = divide128By64(((uint64_t)1) << floorLog2, 0, divisor, rem);
+
+			uint64_t e = divisor - rem;
+			if (e >= (((uint64_t)1) << floorLog2))
+			{
+				// The magic for shift floorLog2 is not precise enough: use one more bit (65 bits).
+				proposed += proposed;
+				uint64_t twiceRem = rem + rem;
+				if ((twiceRem >= divisor) || (twiceRem < rem))
+				{
+					proposed += 1;
+				}
+				_bAdd = true;
+			}
+			_magic = proposed + 1;
+		}
+
+		inline uint64_t getDivisor() const
+		{
+			return _divisor;
+		}
+
+		inline uint64_t divide(uint64_t n) const
+		{
+			if (_magic == 0) return n >> _shift;
+
+			uint64_t q = mulhi(_magic, n);
+			if (_bAdd)
+			{
+				uint64_t t = ((n - q) >> 1) + q;
+				return t >> _shift;
+			}
+			return q >> _shift;
+		}
+
+		// floor(n * a / divisor) = a * q + floor(r * a / divisor), with n = q * divisor + r.
+		// Precondition: (divisor - 1) * a fits in 64 bits (f.e. divisor < 2^32 and a <= 2^32).
+		inline uint64_t mulDiv(uint64_t n, uint64_t a) const
+		{
+			uint64_t q = divide(n);
+			uint64_t r = n - q * _divisor;
+			return q * a + divide(r * a);
+		}
+
+		// Upper 64 bits of the 128 bit product, with 32x32->64 bit multiplies only.
+		static inline uint64_t mulhi(uint64_t a, uint64_t b)
+		{
+			uint64_t aLo = (uint32_t)a, aHi = a >> 32;
+			uint64_t bLo = (uint32_t)b, bHi = b >> 32;
+
+			uint64_t p0 = aLo * bLo;
+			uint64_t p1 = aLo * bHi;
+			uint64_t p2 = aHi * bLo;
+			uint64_t p3 = aHi * bHi;
+
+			uint64_t mid = (p0 >> 32) + (uint32_t)p1 + (uint32_t)p2;
+			return p3 + (p1 >> 32) + (p2 >> 32) + (mid >> 32);
+		}
+
+		// (hi:lo) / d, restoring long division, bit by bit.
+		// Precondition: hi < d (so the quotient fits in 64 bits).
+		static uint64_t divide128By64(uint64_t hi, uint64_t lo, uint64_t d, uint64_t& rem)
+		{
+			assert(hi < d);
+			for (int i = 0; i < 64; i++)
+			{
+				uint64_t carry = hi >> 63;
+				hi = (hi << 1) | (lo >> 63);
+				lo <<= 1;
+				if (carry || (hi >= d))
+				{
+					hi -= d;
+					lo |= 1;
+				}
+			}
+			rem = hi;
+			return lo;
+		}
+	};
+}; // end namespace crt
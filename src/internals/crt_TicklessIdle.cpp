@@ -0,0 +1,140 @@
+// Tickless idle, coordinated with Timers (see CRT_TICKLESS_IDLE in crt_Config.h).
+
+#include <cstdint>
+#include "crt_Config.h"
+
+#ifdef CRT_TICKLESS_IDLE
+
+#ifndef CRT_TIME_SOURCE_TIM5
+#error "CRT_TICKLESS_IDLE requires CRT_TIME_SOURCE_TIM5 (see crt_Config.h)"
+#endif
+
+extern "C" {
+	#include "crt_stm_hal.h"
+	#include "cmsis_os2.h"
+	#include "stmHwTimer5.h"
+}
+
+#include <cassert>
+
+#include "FreeRTOS.h"
+#include "task.h"
+#include "crt_CleanRTOS.h"
+
+// With configUSE_TICKLESS_IDLE 2 (FreeRTOSConfig.h), FreeRTOS calls the function below from
+// its idle task, with the scheduler suspended, when no task needs to run for
+// xExpectedIdleTime ticks.
+//
+// The cpu then sleeps until the first of:
+// - the next FreeRTOS wakeup (a timeout, an osDelay): timer5 compare channel 1 wakes it.
+// - the next deadline of Timers: the interrupt of its hardware timer wakes it, as usual.
+// - any other interrupt.
+// Meanwhile, the SysTick is stopped. Afterwards, the FreeRTOS tick count is stepped by the
+// amount of whole ticks slept, measured with Time (timer5 keeps counting in sleep mode),
+// plus the part of the SysTick period that had elapsed already when it was stopped.
+// The part of a tick that remains, is carried over to the next sleep. So the tick count
+// may lag up to a tick, temporarily, but it does not drift. Time itself is not affected.
+// (except if the cpu wakes later than the next FreeRTOS wakeup: see below)
+// If a SysTick became pending before it was stopped, the sleep is skipped: that tick is
+// counted by its own interrupt, like in the SysTick port of FreeRTOS.
+//
+// Note: this uses sleep mode (__WFI), in which timer2 and timer5 keep running.
+// Stop mode would stop them.
+
+namespace crt
+{
+	static uint32_t tickRemainderCycles = 0; // Part of a tick, passed but not yet stepped.
+
+	// Sleeps shorter than this are not worth stopping the tick for.
+	constexpr uint32_t MIN_SLEEP_TICKS = 2;
+}; // end namespace crt
+
+extern "C" void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+	using namespace crt;
+
+	const uint32_t cyclesPerTick = Time::getCountFrequency() / configTICK_RATE_HZ;
+
+	// The first deadline of Timers bounds the sleep as well: its hardware timer wakes the cpu
+	// for it anyway, so there is no gain in stopping the tick for less.
+	uint64_t sleepTicks = xExpectedIdleTime;
+	uint64_t untilDeadline_us = Timers::getTimeUntilNextDeadline_us();
+	if (untilDeadline_us != UINT64_MAX)
+	{
+		uint64_t deadlineTicks = untilDeadline_us * configTICK_RATE_HZ / 1000000;
+		if (deadlineTicks < sleepTicks) sleepTicks = deadlineTicks;
+	}
+
+	// timer5_wake_at needs the wake count within 2^31 counts. (about 25 seconds at 84MHz)
+	const uint64_t maxSleepTicks = 0x7FFFFFFFu / cyclesPerTick;
+	if (sleepTicks > maxSleepTicks) sleepTicks = maxSleepTicks;
+
+	if (sleepTicks < MIN_SLEEP_TICKS) return; // normal idle, with tick.
+
+	__disable_irq(); // interrupts still end the __WFI below, but are handled after __enable_irq.
+	__DSB();
+	__ISB();
+
+	if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+	{
+		// A task was readied or a context switch pended meanwhile.
+		__enable_irq();
+		return;
+	}
+
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+
+	if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk)
+	{
+		// A tick is due. Let its interrupt count it: continue the SysTick where it stopped.
+		SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+		__enable_irq();
+		return;
+	}
+
+	uint64_t sleepStart = Time::getTotalCycleCount();
+
+	// The part of the current SysTick period that elapsed already, in counts of Time.
+	// (the SysTick counts down from LOAD to 0, in cycles of the core clock)
+	const uint32_t sysTickPeriod = SysTick->LOAD + 1;
+	const uint32_t sysTickElapsed = (sysTickPeriod - SysTick->VAL) % sysTickPeriod;
+	const uint32_t passedCycles = tickRemainderCycles +
+		(uint32_t)(((uint64_t)sysTickElapsed * cyclesPerTick) / sysTickPeriod); // < 2 ticks.
+
+	// Wake at the tick that FreeRTOS expects. (sleepTicks >= 2, so it lies ahead)
+	timer5_wake_at((uint32_t)(sleepStart + sleepTicks * cyclesPerTick - passedCycles));
+
+	TickType_t xModifiableIdleTime = (TickType_t)sleepTicks;
+	configPRE_SLEEP_PROCESSING(xModifiableIdleTime);
+	if (xModifiableIdleTime > 0)
+	{
+		__DSB();
+		__WFI();
+		__ISB();
+	}
+	configPOST_SLEEP_PROCESSING(xModifiableIdleTime);
+
+	timer5_cancel_wake();
+
+	// The time slept, in whole ticks (a 32 bit division: sleeps are < 2^31 counts).
+	uint32_t sleptCycles = (uint32_t)(Time::getTotalCycleCount() - sleepStart) + passedCycles;
+	uint32_t sleptTicks = sleptCycles / cyclesPerTick;
+	tickRemainderCycles = sleptCycles - sleptTicks * cyclesPerTick;
+	if (sleptTicks > xExpectedIdleTime)
+	{
+		// Woken late (f.e. an interrupt with a long handler). FreeRTOS does not allow stepping
+		// beyond its next wakeup: the rest is lost for the tick count.
+		sleptTicks = xExpectedIdleTime;
+		tickRemainderCycles = 0;
+	}
+
+	// Restart the tick from a clean period. (the part of a tick that passed, is in tickRemainderCycles)
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+
+	vTaskStepTick(sleptTicks);
+
+	__enable_irq();
+}
+
+#endif // CRT_TICKLESS_IDLE
@@ -0,0 +1,139 @@
+#pragma once
+
+extern "C" {
+	#include "crt_stm_hal.h"
+
+	#include "cmsis_os2.h"
+}
+
+#include <cstdint>
+#include <cassert>
+
+#include "crt_CleanRTOS.h"
+#include "crt_Time.h"
+#include "crt_Timer.h"
+
+namespace crt
+{
+	// TimerCalibration measures the overhead of the timers once, right after the scheduler
+	// has started, and stores it in Timers (see Timers::getEngineOverhead_us and getTimerOverhead_us).
+	// That replaces compensation values that had to be tweaked by hand for every clock setting
+	// and compiler optimization level.
+	//
+	// It measures with Time::getTotalCycleCount, in two steps:
+	// 1) engine : from Timers::startTimer until the callback in the ISR.
+	// 2) Timer  : from Timer::start until its task wakes up (relay and task switch), on top of 1).
+	// For each, the median of NOF_SAMPLES is taken, and the task exits.
+	// Timers started before the calibration has finished, use the defaults (see Timers::isCalibrated).
+	//
+	// It is created by cleanRTOS_init, with a high priority, such that it runs before the other tasks.
+	class TimerCalibration : public Task
+	{
+	private:
+		static constexpr uint32_t NOF_SAMPLES           = 9;
+		static constexpr uint32_t calibrationDuration_us = 1000;
+
+		Timer timer;
+
+		volatile uint64_t callbackCycles;
+		volatile bool bCallbackFired;
+
+	public:
+		TimerCalibration(const char *taskName, osPriority_t taskPriority, unsigned int taskSizeBytes) :
+		Task(taskName, taskPriority, taskSizeBytes), timer(this), callbackCycles(0), bCallbackFired(false)
+		{
+			start();
+		}
+
+	private:
+		static void engineCallback(void* userArg)
+		{
+			TimerCalibration* pThis = (TimerCalibration*)userArg;
+			pThis->callbackCycles = Time::getTotalCycleCount();
+			pThis->bCallbackFired = true;
+		}
+
+		static inline int32_t cyclesToUs(uint64_t cycles)
+		{
+			return (int32_t)Time::cyclesToMicroseconds(cycles);
+		}
+
+		static int32_t median(int32_t* arSamples)
+		{
+			// insertion sort: few samples.
+			for (uint32_t i = 1; i < NOF_SAMPLES; i++)
+			{
+				int32_t v = arSamples[i];
+				uint32_t j = i;
+				for (; (j > 0) && (arSamples[j-1] > v); j--)
+				{
+					arSamples[j] = arSamples[j-1];
+				}
+				arSamples[j] = v;
+			}
+			return arSamples[NOF_SAMPLES/2];
+		}
+
+		static inline uint32_t addClamped(uint32_t current_us, int32_t late_us)
+		{
+			int32_t result = (int32_t)current_us + late_us;
+			return (result < 0) ? 0 : (uint32_t)result;
+		}
+
+		// returns the median of how much later than requested the engine callback was called.
+		int32_t measureEngineLateness()
+		{
+			int32_t arLate[NOF_SAMPLES];
+			TimerHandle hTimer = Timers::createTimer("calibration", engineCallback, this);
+			assert(Timers::isValidTimerHandle(hTimer));
+
+			for (uint32_t i = 0; i < NOF_SAMPLES; i++)
+			{
+				bCallbackFired = false;
+				uint64_t startCycles = Time::getTotalCycleCount();
+				Timers::startTimer(hTimer, calibrationDuration_us, false /*bPeriodic*/);
+				while (!bCallbackFired) {} // busy wait: no task switch in the measurement.
+
+				arLate[i] = cyclesToUs(callbackCycles - startCycles) - (int32_t)calibrationDuration_us;
+			}
+			Timers::destroyTimer(hTimer);
+			return median(arLate);
+		}
+
+		// returns the median of how much later than requested the task woke up on a Timer.
+		int32_t measureTimerLateness()
+		{
+			int32_t arLate[NOF_SAMPLES];
+			for (uint32_t i = 0; i < NOF_SAMPLES; i++)
+			{
+				uint64_t startCycles = Time::getTotalCycleCount();
+				timer.start(calibrationDuration_us);
+				wait(timer);
+				uint64_t wakeCycles = Time::getTotalCycleCount();
+
+				arLate[i] = cyclesToUs(wakeCycles - startCycles) - (int32_t)calibrationDuration_us;
+			}
+			return median(arLate);
+		}
+
+		void main() override
+		{
+			// The measured lateness is what remains after the current compensation,
+			// so it is added to it.
+			int32_t engineLate_us = measureEngineLateness();
+			uint32_t engineOverhead_us = addClamped(Timers::getEngineOverhead_us(), engineLate_us);
+			Timers::setOverheads(engineOverhead_us, Timers::getTimerOverhead_us(), false /*bCalibrated*/);
+
+			int32_t timerLate_us = measureTimerLateness();
+			uint32_t timerOverhead_us = addClamped(Timers::getTimerOverhead_us(), timerLate_us);
+
+			timer.stop();
+			Timers::destroyTimer(timer.getTimerHandle()); // This task and its timer are not used anymore.
+
+			// Last: after isCalibrated, all timer handles are available to the application.
+			Timers::setOverheads(engineOverhead_us, timerOverhead_us, true /*bCalibrated*/);
+
+			osThreadExit();
+		}
+	}; // end class TimerCalibration
+}; // end namespace crt
@@ -0,0 +1,132 @@
+#pragma once
+#include <cstdint>
+#include <cassert>
+
+namespace crt
+{
+	// Timer queue engine for Timers_template: a binary min-heap on wake time.
+	// (same interface as TimerQueue_SortedList, see crt_TimerQueue_SortedList.h)
+	//
+	// The heap is an array of pointers to the preallocated timers (no allocation).
+	// Each timer stores its position in that array (queueHook.heapIndex), so a running
+	// timer can be removed without searching for it.
+	//   insert, remove, popFirst : O(log n)  (at most 7 levels for 100 timers)
+	//   getFirst                 : O(1)
+	// So the worst case time with interrupts masked is bounded, regardless of how many
+	// timers are running, at the cost of only MAX_NOF_TIMERS pointers.
+	//
+	// Unlike TimerQueue_SortedList, the order among timers with equal keys is not defined.
+	// (They fire in the same collectDueTimers call anyway.)
+	template <typename NODE, int32_t MAX_NOF_TIMERS>
+	class TimerQueue_BinaryHeap
+	{
+	public:
+		static constexpr int32_t HEAPINDEX_NONE = -1;	// Not queued.
+
+		struct Hook
+		{
+			int32_t heapIndex = HEAPINDEX_NONE;
+		};
+
+	private:
+		NODE*   _arHeap[MAX_NOF_TIMERS];	// _arHeap[0] is the earliest timer.
+		int32_t _size;
+
+	public:
+		TimerQueue_BinaryHeap() : _arHeap{}, _size(0)
+		{}
+
+		// returnvalue: true if node became the first (earliest) timer.
+		bool insert(NODE& node)
+		{
+			assert(node.queueHook.heapIndex == HEAPINDEX_NONE);
+			assert(_size < MAX_NOF_TIMERS);
+
+			int32_t i = _size++;
+			place(node, i);
+			return siftUp(i) == 0;
+		}
+
+		void remove(NODE& node)
+		{
+			int32_t i = node.queueHook.heapIndex;
+			if (i == HEAPINDEX_NONE) return; // not queued.
+
+			node.queueHook.heapIndex = HEAPINDEX_NONE;
+			_size--;
+			if (i == _size) return; // it was the last one.
+
+			// Move the last one into the gap, and restore the heap property from there.
+			place(*_arHeap[_size], i);
+			if (siftUp(i) == i)
+			{
+				siftDown(i);
+			}
+		}
+
+		inline NODE* getFirst()
+		{
+			return (_size > 0) ? _arHeap[0] : nullptr;
+		}
+
+		NODE* popFirst()
+		{
+			NODE* first = getFirst();
+			if (first)
+			{
+				remove(*first);
+			}
+			return first;
+		}
+
+		inline void advance(uint64_t /*now*/)
+		{
+			// The heap has no notion of "current time".
+		}
+
+		inline bool isEmpty()
+		{
+			return _size == 0;
+		}
+
+	private:
+		inline void place(NODE& node, int32_t i)
+		{
+			_arHeap[i] = &node;
+			node.queueHook.heapIndex = i;
+		}
+
+		// returns the final position.
+		int32_t siftUp(int32_t i)
+		{
+			NODE* node = _arHeap[i];
+			while (i > 0)
+			{
+				int32_t parent = (i - 1) >> 1;
+				if (!(node->getQueueKey() < _arHeap[parent]->getQueueKey())) break;
+				place(*_arHeap[parent], i);
+				i = parent;
+			}
+			place(*node, i);
+			return i;
+		}
+
+		void siftDown(int32_t i)
+		{
+			NODE* node = _arHeap[i];
+			while (true)
+			{
+				int32_t child = 2 * i + 1;
+				if (child >= _size) break;
+				if ((child + 1 < _size) && (_arHeap[child + 1]->getQueueKey() < _arHeap[child]->getQueueKey()))
+				{
+					child++;
+				}
+				if (!(_arHeap[child]->getQueueKey() < node->getQueueKey())) break;
+				place(*_arHeap[child], i);
+				i = child;
+			}
+			place(*node, i);
+		}
+	};
+}; // end namespace crt
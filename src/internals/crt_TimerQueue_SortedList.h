@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+
+namespace crt
+{
+	// Timer queue engine for Timers_template: a singly linked list, sorted on wake time.
+	// This is the original engine of Timers_template.
+	// Insert and remove walk the list, so they cost O(n) (while interrupts are masked).
+	// The first timer is at the head, so getFirst and popFirst are O(1).
+	//
+	// Interface of a timer queue engine (see also crt_TimerQueue_TimingWheel.h):
+	//   Hook         : member type. NODE must contain a member "Hook queueHook".
+	//   insert(node) : returns true if node became the first (earliest) timer.
+	//   remove(node) : removes node, if it is queued (otherwise no-op).
+	//   getFirst()   : earliest timer, or nullptr if empty.
+	//   popFirst()   : removes and returns the earliest timer, or nullptr if empty.
+	//   advance(now) : called after all timers with key <= now have been popped.
+	//
+	// NODE must provide "uint64_t getQueueKey() const" (its wake time).
+	// Among equal keys, the timer that was inserted first, comes first.
+	template <typename NODE, int32_t MAX_NOF_TIMERS>
+	class TimerQueue_SortedList
+	{
+	public:
+		struct Hook
+		{
+			NODE* pNext = nullptr;
+		};
+
+	private:
+		NODE* _pHead;	// List of "active timers" (for which the "alarm" has been set).
+
+	public:
+		TimerQueue_SortedList() : _pHead(nullptr)
+		{}
+
+		// returnvalue: headchanged
+		bool insert(NODE& node)
+		{
+			if (_pHead == nullptr) { _pHead = &node; node.queueHook.pNext = nullptr; return true; }
+
+			if (node.getQueueKey() < _pHead->getQueueKey()) {
+				node.queueHook.pNext = _pHead;
+				_pHead = &node;
+				return true;
+			}
+			NODE* prev = _pHead;
+			NODE* curr = _pHead->queueHook.pNext;
+			while (curr && !(node.getQueueKey() < curr->getQueueKey())) {
+				prev = curr;
+				curr = curr->queueHook.pNext;
+			}
+			prev->queueHook.pNext = &node;
+			node.queueHook.pNext = curr;
+			return false;
+		}
+
+		void remove(NODE& node)
+		{
+			NODE* curr = _pHead;
+			NODE* prev = nullptr;
+			while (curr) {
+				if (curr == &node) {
+					if (prev) {prev->queueHook.pNext = curr->queueHook.pNext;}
+					else {_pHead = curr->queueHook.pNext;} // head verwijderen. ..dit verandert de head ook..
+					curr->queueHook.pNext = nullptr; // tbv debug-overzicht
+					return;
+				}
+				prev = curr;
+				curr = curr->queueHook.pNext;
+			}
+		}
+
+		inline NODE* getFirst()
+		{
+			return _pHead;
+		}
+
+		NODE* popFirst()
+		{
+			NODE* first = _pHead;
+			if (first)
+			{
+				_pHead = first->queueHook.pNext;
+				first->queueHook.pNext = nullptr;
+			}
+			return first;
+		}
+
+		inline void advance(uint64_t /*now*/)
+		{
+			// The list has no notion of "current time".
+		}
+
+		inline bool isEmpty()
+		{
+			return _pHead == nullptr;
+		}
+	};
+}; // end namespace crt
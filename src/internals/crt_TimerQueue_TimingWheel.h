@@ -0,0 +1,334 @@
+#pragma once
+#include <cstdint>
+
+namespace crt
+{
+	// Timer queue engine for Timers_template: a hierarchical timing wheel.
+	// (same interface as TimerQueue_SortedList, see crt_TimerQueue_SortedList.h)
+	//
+	// Insert and remove are O(1): a timer is linked into a slot of a wheel level
+	// (doubly linked), and an occupancy bitmap per level is updated.
+	//
+	// Layout: NOF_LEVELS levels of 64 slots. A slot of level L spans a block of 64^L keys
+	// (cycles of the time base of Timers_template). A timer is put in the lowest level L of
+	// which the block of 64^(L+1) keys that contains _cursor, also contains its key: in the
+	// slot of its block of 64^L keys. So every key in level L is later than every key in the
+	// levels below, and the slots of a level are in the order of their keys (no wrap around).
+	// The levels together span the block of 64^6 cycles that contains _cursor (about 7 minutes
+	// at 168MHz, or 24 days in LPTIM1 counts). Timers beyond that (rare: only long waits)
+	// go in an overflow list.
+	//
+	// When the cursor enters a block, the slot of that block is cascaded to lower levels, like
+	// in a classic hierarchical wheel. When it enters the next block of 64^6 cycles, the overflow
+	// list is relinked into the levels. So every timer moves down at most NOF_LEVELS times:
+	// O(1) amortized per timer.
+	//
+	// The earliest timer is cached in _pFirst, so getFirst is O(1). It is updated at insert,
+	// and looked up again only after the removal of that first timer (findFirst): in the first
+	// occupied slot (a bit scan) of the lowest occupied level. If that is a slot of a higher
+	// level, no timer lies before its block, so the cursor is moved ahead to the start of that
+	// block, and the slot is cascaded, till the earliest timers are on level 0. A slot of level 0
+	// holds timers with the same key: any of them is the earliest.
+	// Except the slot of the cursor: timers that are inserted when they lie before the cursor
+	// already (overdue, or before a cursor that findFirst moved ahead), go there too. That slot
+	// is kept sorted lazily: a timer that is linked in front, keeps it sorted if its key is not
+	// later than that of the head. Otherwise findFirst sorts it (merge sort) when needed.
+	// So findFirst costs at most NOF_LEVELS bit scans and cascades (O(1) amortized, see above),
+	// plus O(k log k) for k such early timers after an insert that disordered them. The overflow
+	// list is sorted lazily as well, and only looked at if the levels are empty.
+	// Unlike TimerQueue_SortedList, the order among timers with equal keys is not defined.
+	// (They fire in the same collectDueTimers call anyway.)
+	//
+	// Memory: NOF_LEVELS*64 slot pointers + NOF_LEVELS+1 bitmaps (about 1.6kB on a 32 bit mcu).
+	template <typename NODE, int32_t MAX_NOF_TIMERS>
+	class TimerQueue_TimingWheel
+	{
+	public:
+		static constexpr uint32_t NOF_LEVELS = 6;
+		static constexpr uint32_t SLOT_BITS  = 6;	// 64 slots per level: one uint64_t bitmap per level.
+		static constexpr uint32_t NOF_SLOTS  = (1u << SLOT_BITS);
+		static constexpr uint32_t SPAN_BITS  = NOF_LEVELS * SLOT_BITS;	// the levels span a block of 2^SPAN_BITS keys.
+		static constexpr int8_t   LEVEL_NONE     = -1;	// Not queued.
+		static constexpr int8_t   LEVEL_OVERFLOW = (int8_t)NOF_LEVELS;
+
+		struct Hook
+		{
+			NODE*   pNext = nullptr;
+			NODE*   pPrev = nullptr;
+			int8_t  level = LEVEL_NONE;
+			uint8_t slot  = 0;
+		};
+
+	private:
+		NODE*    _arSlots[NOF_LEVELS][NOF_SLOTS];
+		uint64_t _arOccupied[NOF_LEVELS];	// bit i set <-> _arSlots[level][i] not empty.
+		uint64_t _sortedLevel0;				// bit i set -> _arSlots[0][i] is sorted on key.
+		NODE*    _pOverflow;
+		bool     _bOverflowSorted;
+		uint64_t _cursor;					// All queued timers have a key >= _cursor (or lay before it at insertion).
+		NODE*    _pFirst;					// Cached earliest timer.
+
+	public:
+		TimerQueue_TimingWheel() : _arSlots{}, _arOccupied{}, _sortedLevel0(~(uint64_t)0), _pOverflow(nullptr),
+			_bOverflowSorted(true), _cursor(0), _pFirst(nullptr)
+		{}
+
+		// returnvalue: true if node became the first (earliest) timer.
+		bool insert(NODE& node)
+		{
+			uint64_t key = node.getQueueKey();
+			if (key < _cursor)
+			{
+				key = _cursor; // Before the cursor: put it in the current slot.
+			}
+
+			link(node, key);
+
+			if ((_pFirst == nullptr) || (node.getQueueKey() < _pFirst->getQueueKey()))
+			{
+				_pFirst = &node;
+				return true;
+			}
+			return false;
+		}
+
+		void remove(NODE& node)
+		{
+			if (node.queueHook.level == LEVEL_NONE) return; // not queued.
+
+			unlink(node);
+
+			if (&node == _pFirst)
+			{
+				_pFirst = findFirst();
+			}
+		}
+
+		inline NODE* getFirst()
+		{
+			return _pFirst;
+		}
+
+		NODE* popFirst()
+		{
+			NODE* first = _pFirst;
+			if (first)
+			{
+				remove(*first);
+			}
+			return first;
+		}
+
+		// Precondition: all timers with a key <= now have been popped.
+		// So the slots that the cursor passes are empty, and only the slots of the blocks it
+		// enters need to be cascaded. (_pFirst stays the same: no timer is added or removed)
+		void advance(uint64_t now)
+		{
+			if (now <= _cursor) return; // (findFirst may have moved it ahead already)
+
+			uint64_t previous = _cursor;
+			_cursor = now;
+
+			if ((previous >> SPAN_BITS) != (now >> SPAN_BITS))
+			{
+				// The levels are empty (their keys were <= now). The overflow timers of the new block move in.
+				relinkOverflow();
+			}
+
+			// From high to low: a cascaded timer may land in the slot of the cursor on the level below.
+			for (uint32_t l = NOF_LEVELS - 1; l > 0; l--)
+			{
+				uint32_t shift = l * SLOT_BITS;
+				if ((previous >> shift) != (now >> shift))
+				{
+					cascade(l, (uint32_t)((now >> shift) & (NOF_SLOTS - 1)));
+				}
+			}
+		}
+
+		inline bool isEmpty()
+		{
+			return _pFirst == nullptr;
+		}
+
+	private:
+		void link(NODE& node, uint64_t key)
+		{
+			NODE** ppHead = &_pOverflow;
+			int8_t level  = LEVEL_OVERFLOW;
+			uint8_t slot  = 0;
+
+			for (uint32_t l = 0; l < NOF_LEVELS; l++)
+			{
+				uint32_t shift = l * SLOT_BITS;
+				if ((key >> (shift + SLOT_BITS)) == (_cursor >> (shift + SLOT_BITS)))
+				{
+					level = (int8_t)l;
+					slot  = (uint8_t)((key >> shift) & (NOF_SLOTS - 1));
+					ppHead = &_arSlots[l][slot];
+					break;
+				}
+			}
+
+			// In front of the head: a sorted list stays sorted if its key is not later than that of the head.
+			if (*ppHead && (node.getQueueKey() > (*ppHead)->getQueueKey()))
+			{
+				if (level == LEVEL_OVERFLOW) _bOverflowSorted = false;
+				else if (level == 0)         _sortedLevel0 &= ~(((uint64_t)1) << slot);
+			}
+			if (level != LEVEL_OVERFLOW)
+			{
+				_arOccupied[level] |= (((uint64_t)1) << slot);
+			}
+
+			node.queueHook.level = level;
+			node.queueHook.slot  = slot;
+			node.queueHook.pPrev = nullptr;
+			node.queueHook.pNext = *ppHead;
+			if (*ppHead) { (*ppHead)->queueHook.pPrev = &node; }
+			*ppHead = &node;
+		}
+
+		// Keeps the order of the others: a sorted slot stays sorted.
+		void unlink(NODE& node)
+		{
+			Hook& hook = node.queueHook;
+			NODE** ppHead = (hook.level == LEVEL_OVERFLOW) ? &_pOverflow : &_arSlots[hook.level][hook.slot];
+
+			if (hook.pPrev) { hook.pPrev->queueHook.pNext = hook.pNext; }
+			else            { *ppHead = hook.pNext; }
+			if (hook.pNext) { hook.pNext->queueHook.pPrev = hook.pPrev; }
+
+			if (*ppHead == nullptr)
+			{
+				// Empty: sorted.
+				if (hook.level == LEVEL_OVERFLOW) _bOverflowSorted = true;
+				else
+				{
+					_arOccupied[hook.level] &= ~(((uint64_t)1) << hook.slot);
+					if (hook.level == 0) _sortedLevel0 |= (((uint64_t)1) << hook.slot);
+				}
+			}
+
+			hook.pNext = nullptr;
+			hook.pPrev = nullptr;
+			hook.level = LEVEL_NONE;
+		}
+
+		// Relinks the timers of a list relative to the cursor.
+		void relink(NODE* p)
+		{
+			while (p)
+			{
+				NODE* pNext = p->queueHook.pNext;
+				uint64_t key = p->getQueueKey();
+				link(*p, (key < _cursor) ? _cursor : key);
+				p = pNext;
+			}
+		}
+
+		// The slot of the block that the cursor entered (level > 0): its timers move to lower levels.
+		void cascade(uint32_t level, uint32_t slot)
+		{
+			NODE* p = _arSlots[level][slot];
+			if (p == nullptr) return;
+			_arSlots[level][slot] = nullptr;
+			_arOccupied[level] &= ~(((uint64_t)1) << slot);
+			relink(p);
+		}
+
+		void relinkOverflow()
+		{
+			NODE* p = _pOverflow;
+			_pOverflow = nullptr;
+			_bOverflowSorted = true;
+			relink(p); // the ones beyond the new block go back in the overflow list.
+		}
+
+		// Sorts a list on key, and returns its new head. Bottom-up merge sort: O(k log k),
+		// without recursion or extra memory (it runs in the timer interrupt).
+		static NODE* sortList(NODE* pList)
+		{
+			if (pList == nullptr) return nullptr;
+
+			for (uint32_t width = 1; ; width *= 2)
+			{
+				NODE* p = pList;
+				NODE* pTail = nullptr;
+				pList = nullptr;
+				uint32_t nofMerges = 0;
+
+				while (p)
+				{
+					// Merge the run of width timers at p with the next run at q.
+					nofMerges++;
+					NODE* q = p;
+					uint32_t pSize = 0;
+					while ((pSize < width) && q) { pSize++; q = q->queueHook.pNext; }
+					uint32_t qSize = width;
+
+					while ((pSize > 0) || ((qSize > 0) && q))
+					{
+						NODE* e;
+						if      (pSize == 0)                 { e = q; q = q->queueHook.pNext; qSize--; }
+						else if ((qSize == 0) || !q)         { e = p; p = p->queueHook.pNext; pSize--; }
+						else if (p->getQueueKey() <= q->getQueueKey()) { e = p; p = p->queueHook.pNext; pSize--; }
+						else                                 { e = q; q = q->queueHook.pNext; qSize--; }
+
+						if (pTail) { pTail->queueHook.pNext = e; }
+						else       { pList = e; }
+						pTail = e;
+					}
+					p = q;
+				}
+				pTail->queueHook.pNext = nullptr;
+
+				if (nofMerges <= 1) break;
+			}
+
+			// Restore the back links.
+			NODE* pPrev = nullptr;
+			for (NODE* p = pList; p; p = p->queueHook.pNext)
+			{
+				p->queueHook.pPrev = pPrev;
+				pPrev = p;
+			}
+			return pList;
+		}
+
+		// The earliest timer. (see the complexity above)
+		NODE* findFirst()
+		{
+			for (;;)
+			{
+				uint32_t l = 0;
+				while ((l < NOF_LEVELS) && (_arOccupied[l] == 0)) l++;
+				if (l == NOF_LEVELS) break; // only the overflow list is left (if any).
+
+				uint32_t slot = (uint32_t)__builtin_ctzll(_arOccupied[l]); // no wrap around: the earliest block.
+				if (l == 0)
+				{
+					uint64_t bit = ((uint64_t)1) << slot;
+					if ((_sortedLevel0 & bit) == 0)
+					{
+						_arSlots[0][slot] = sortList(_arSlots[0][slot]);
+						_sortedLevel0 |= bit;
+					}
+					return _arSlots[0][slot];
+				}
+
+				// No timer lies before the block of this slot: move the cursor to its start.
+				uint32_t shift = l * SLOT_BITS;
+				_cursor = ((((_cursor >> (shift + SLOT_BITS)) << SLOT_BITS) | slot) << shift);
+				cascade(l, slot);
+			}
+
+			if (!_bOverflowSorted)
+			{
+				_pOverflow = sortList(_pOverflow);
+				_bOverflowSorted = true;
+			}
+			return _pOverflow;
+		}
+	};
+}; // end namespace crt
@@ -8,174 +8,452 @@ extern "C" {
 	#include "cmsis_os2.h"
 }
 
+#include "crt_Config.h"
 #include "crt_IndexPool.h"
+#include "crt_TimerQueue_SortedList.h"
+#include "crt_TimerQueue_TimingWheel.h"
+#include "crt_TimerQueue_BinaryHeap.h"
+#include "crt_MpscRing.h"
 #include <array>
+#include <limits>
+#include <type_traits>
 #include <stdint.h>
 #include <assert.h>
+#include <cstdio>
 #include <crt_Time.h>
-#include "stmHwTimer2.h"
+#include "crt_HwTimerBackend_Tim2.h"
+#include "crt_HwTimerBackend_Lptim.h"
+#ifdef CRT_TIMER_BACKEND_SIM
+#include "crt_HwTimerBackend_Sim.h" // in src/internals/sim
+#endif
 
 // Precondition o use of this class: Time Object was instantianted.
 
 namespace crt
 {
+	// The hardware timer backend of Timers, selected in crt_Config.h.
+#if defined(CRT_TIMER_BACKEND_SIM)
+	using HwTimerBackend_Default = HwTimerBackend_Sim;	// host simulation (see sim/crt_Sim.h).
+#elif defined(CRT_TIMER_BACKEND_LPTIM)
+	using HwTimerBackend_Default = HwTimerBackend_Lptim;
+#else
+	using HwTimerBackend_Default = HwTimerBackend_Tim2;
+#endif
+
 	//typedef int32_t TimerHandle;
-	using TimerHandle = int32_t;
+	using TimerHandle = TimerHandleInt; // int32_t, unless configured smaller in crt_Config.h.
+
+	// How a periodic timer is rescheduled after it fired.
+	enum class PeriodMode : uint8_t
+	{
+		FixedDelay,	// next wake = time of handling the fire + period. (default)
+					// Latency of handling a fire is added to the period: the phase drifts.
+		FixedRate	// next wake = previous wake + period.
+					// Stays phase-locked to wall time (f.e. for ADC sampling or PWM updates).
+	};
+
+	// What a FixedRate timer does when its next wake time has passed already
+	// by the time its previous fire is handled (an overrun).
+	enum class OverrunPolicy : uint8_t
+	{
+		CatchUp,	// Fire immediately, once for every missed period. Keeps the amount of fires exact.
+		Skip		// Skip the missed periods. Fire at the next period boundary in the future.
+	};
+
+#ifdef CRT_TIMER_STATISTICS
+	// Per timer statistics of the lateness of its fires: the time from its wake time until the
+	// timer interrupt (or task) that handled the fire. It includes the use of slack, if any.
+	// Lateness is in cycles of the time base of Timers (see Timers::cyclesToMicroseconds).
+	// Histogram: bucket 0 counts lateness < 2^8 cycles, bucket b counts [2^(b+7), 2^(b+8)),
+	// the last bucket counts everything above. (at 168MHz: 1.5us, 3us, .. and > 0.8ms)
+	struct TimerStats
+	{
+		static constexpr uint32_t NOF_BUCKETS = 12;
+		static constexpr uint32_t FIRST_BUCKET_BITS = 8;
+
+		uint32_t nofFires;
+		uint32_t minLateness;
+		uint32_t maxLateness;
+		uint64_t totalLateness;	// mean = totalLateness / nofFires.
+		uint32_t arHistogram[NOF_BUCKETS];
+
+		void reset()
+		{
+			nofFires = 0;
+			minLateness = UINT32_MAX;
+			maxLateness = 0;
+			totalLateness = 0;
+			for (uint32_t& count : arHistogram) count = 0;
+		}
+
+		inline void addFire(uint32_t lateness)
+		{
+			nofFires++;
+			if (lateness < minLateness) minLateness = lateness;
+			if (lateness > maxLateness) maxLateness = lateness;
+			totalLateness += lateness;
+
+			// bit length via clz: no loop.
+			uint32_t nofBits = (lateness == 0) ? 0 : (32 - (uint32_t)__builtin_clz(lateness));
+			uint32_t bucket = (nofBits <= FIRST_BUCKET_BITS) ? 0 : (nofBits - FIRST_BUCKET_BITS);
+			if (bucket >= NOF_BUCKETS) bucket = NOF_BUCKETS - 1;
+			arHistogram[bucket]++;
+		}
+	};
+#endif
 
-	// Uses timer2 (a 32 bits timer) of the stm chip, via stmHwTimer2.
+	// One timer start, for Timers_template::startTimers. The arguments are those of startTimer,
+	// plus offset_us: the first fire is delayed by offset_us extra (the period is not).
+	// That allows a group of periodic timers with staggered phases.
+	struct TimerStartRequest
+	{
+		TimerHandle hTimer;
+		uint64_t duration_us;
+		bool bPeriodic;
+		PeriodMode periodMode;
+		OverrunPolicy overrunPolicy;
+		uint32_t slack_us;
+		uint32_t offset_us;
+
+		TimerStartRequest(TimerHandle hTimer = -1, uint64_t duration_us = 0, bool bPeriodic = false,
+		                  PeriodMode periodMode = PeriodMode::FixedDelay,
+		                  OverrunPolicy overrunPolicy = OverrunPolicy::Skip,
+		                  uint32_t slack_us = 0, uint32_t offset_us = 0) :
+		hTimer(hTimer), duration_us(duration_us), bPeriodic(bPeriodic), periodMode(periodMode),
+		overrunPolicy(overrunPolicy), slack_us(slack_us), offset_us(offset_us)
+		{}
+	};
+
+	// Uses a single hardware timer of the stm chip, via the backend HW_TIMER (the third template
+	// parameter): timer2 by default, or LPTIM1 (see crt_HwTimerBackend_Tim2.h and crt_HwTimerBackend_Lptim.h).
 	// Extern (in CleanRTOS.h), a typedef renames the templatespecialisation to the name Timers, like this:
 	// (to avoid the need of passing the template parameter around).
 	// typedef crt::Timers_template<MAX_NOF_TIMERS> Timers;
-	template <int32_t MAX_NOF_TIMERS>
+	//
+	// The second template parameter selects the engine that keeps the running timers
+	// sorted on wake time (it is manipulated while interrupts are masked):
+	//   TimerQueue_SortedList  : sorted linked list. O(n) insert/remove. Least memory. (default)
+	//   TimerQueue_TimingWheel : hierarchical timing wheel. O(1) insert/remove. ~1.6kB extra.
+	//   TimerQueue_BinaryHeap  : binary min-heap. O(log n) insert/remove, bounded worst case.
+	//                            MAX_NOF_TIMERS pointers extra.
+	// For example: using Timers = Timers_template<MAX_NOF_TIMERS, TimerQueue_TimingWheel>;
+	// (the backend is normally selected in crt_Config.h, but can be passed explicitly as well)
+	// (see src/internals/tests/TimerQueues for a benchmark of the engines)
+	//
+	// Internally, all times are in cycles of the time base of the backend (getTimeBaseCount): the
+	// cpu cycles of Time, or, for LPTIM1, its own counts, which keep running in Stop modes.
+	// So the timer interrupt needs no 64 bit divisions. Microseconds are converted to cycles at
+	// the API (task context), and only the delta for the hardware timer is converted back, with
+	// a 32 bit division (or, for a time base below 1MHz, a multiplication).
+	//
+	// Slack: a timer may be started with a slack. It then may fire anywhere in
+	// [wakeTime, wakeTime + slack]. The queue is sorted on that latest time (the deadline),
+	// and the hardware timer is set to the earliest deadline. When it fires, all timers from
+	// the head of the queue whose wakeTime has passed fire along (like hrtimer slack in linux).
+	// So timers with overlapping windows share a single interrupt.
+	//
+	// If CRT_TIMERS_COMMAND_QUEUE is defined (crt_Config.h), tasks don't manipulate the timer queue.
+	// startTimer(s) and stopTimer post a command in a lock-free ring (see crt_MpscRing.h) and
+	// trigger the timer interrupt in software. Only the timer interrupt manipulates the queue.
+	// So task-side timer operations never mask interrupts, nor stop the hardware timer.
+	// (a post suspends the scheduler for the few instructions of the push, see postCommand)
+	// It requires a free running backend (timer2 with CRT_TIMER2_FREE_RUNNING, or LPTIM1).
+	// stopTimer and destroyTimer wait until their command has been applied (the timer interrupt
+	// preempts the task right away), so after they return, the timer won't fire anymore.
+	// Don't call them from a critical section or from a timer callback, in that mode.
+	template <int32_t MAX_NOF_TIMERS, template <typename, int32_t> class TIMER_QUEUE = TimerQueue_SortedList,
+	          class HW_TIMER = HwTimerBackend_Default>
 	class Timers_template
 	{
 		typedef void (*TimerArgsCallback)(void*);  // the void* parameter is the userArg.
 
+		static_assert(std::is_signed<TimerHandle>::value, "TimerHandleInt must be signed (TimerHandle_None is -1)");
+		static_assert(MAX_NOF_TIMERS <= std::numeric_limits<TimerHandle>::max(),
+		              "MAX_NOF_TIMERS doesn't fit in TimerHandleInt (see crt_Config.h)");
+
+#ifdef CRT_TIMERS_COMMAND_QUEUE
+		static_assert(HW_TIMER::bFreeRunning,
+		              "CRT_TIMERS_COMMAND_QUEUE requires a free running hardware timer: CRT_TIMER2_FREE_RUNNING or CRT_TIMER_BACKEND_LPTIM (see crt_Config.h)");
+#endif
+
 	private:
+		struct HwTimer;
+		using TimerQueue = TIMER_QUEUE<HwTimer, MAX_NOF_TIMERS>;
+
+		// The fields are ordered from large to small, to avoid padding: MAX_NOF_TIMERS of them are preallocated.
 		struct HwTimer
 		{
-			const char* name;
+			// Times in cycles of the time base (see getTotalCycleCount).
+			uint64_t sleepTime;    // equals periodic time if bPerioc==true.
+			uint64_t wakeTime;     // earliest time to fire.
 			TimerArgsCallback callback;
 			void* userArg;
-			uint32_t sleepTime_us; // equals periodic time if bPerioc==true.
-			uint64_t wakeTime_us;
-			HwTimer* pNext;
+			HwTimer* pNextFired; // used to collect fired timers.
+#ifndef CRT_TIMER_NO_NAMES
+			const char* name;
+#endif
+			typename TimerQueue::Hook queueHook; // used by _timerQueue, while the timer is running.
+			uint32_t slack;        // may fire up to slack cycles after wakeTime.
+			uint32_t nofOverruns;  // FixedRate only: amount of missed periods.
+#ifdef CRT_TIMER_STATISTICS
+			TimerStats stats;
+#endif
+			TimerHandle hTimer; // it's own entry in arTimers.
 			bool bPeriodic;
 			bool bRunning;
-			TimerHandle hTimer; // it's own entry in arTimers.
+			PeriodMode periodMode;
+			OverrunPolicy overrunPolicy;
+
+			inline uint64_t getQueueKey() const { return wakeTime + slack; } // the deadline.
 
 			void reset()
 			{
+#ifndef CRT_TIMER_NO_NAMES
 				name = nullptr;
+#endif
 				userArg = nullptr;
-				pNext = nullptr;
+				pNextFired = nullptr;
 				hTimer = -1;
 			}
 		};
 
-		IndexPool<MAX_NOF_TIMERS> 			  _indexPoolTimerCreation   = {};
-		::std::array<HwTimer,MAX_NOF_TIMERS> _arTimers    = {};  // geprealloceerde timers, tegelijk listitems.
+		IndexPool<MAX_NOF_TIMERS, TimerHandle> _indexPoolTimerCreation   = {};
+		::std::array<HwTimer,MAX_NOF_TIMERS> _arTimers    = {};  // geprealloceerde timers, tegelijk queue-items.
 
-		HwTimer* _pHead;	     // List of "active timers" (for which the "alarm" has been set).
+		TimerQueue _timerQueue;	 // "active timers" (for which the "alarm" has been set), sorted on deadline.
 		TimerHandle _hTimerHardwareActivatedFor;
 
+		uint32_t _nofHwTimerInterrupts;	// statistics, to measure the effect of slack.
+		uint32_t _nofCoalescedFires;	// timers that fired along before their deadline (saving an interrupt).
+
+		// Overhead compensation, measured at startup by TimerCalibration (see crt_TimerCalibration.h).
+		volatile uint32_t _engineOverhead_us;	// from startTimer to callback, beyond the requested duration.
+		volatile uint32_t _timerOverhead_us;	// additionally, from Timer::start to the wakeup of its task.
+		volatile bool     _bCalibrated;
+
+		// Clock, for the conversions at the API boundary and for the hardware timer.
+		uint32_t _countFrequency_Hz;
+		uint32_t _cyclesPerUs;		// 0 for a time base below 1MHz: then _usPerCycle_q32 is used.
+		uint64_t _usPerCycle_q32;
+		bool     _bWholeMHz;
+
+		uint32_t _maxHwDelta_us;	// cap of a single hardware timer programming (see setMaxHwDelta_us).
+
+#ifdef CRT_TIMERS_MEASURE_ISR
+		// Duration of handleHwTimerInterrupt, in cycles.
+		uint32_t _isrCyclesMax;
+		uint64_t _isrCyclesTotal;
+		uint32_t _nofIsrMeasured;
+#endif
+
 	public:
 		constexpr static TimerHandle TimerHandle_None = -1;
 		constexpr static uint64_t minimumWaitTimeUs   = 100; // Dependent on clock settings - what is still possible and feasible.
+		constexpr static uint32_t defaultTimerOverhead_us = 50; // Used by Timer until the calibration has finished.
 
 	private:
 		struct FiredList { HwTimer* head=nullptr; HwTimer* tail=nullptr; };
 
-		void collectDueTimers(uint64_t now_us, FiredList& out) {
-		    while (_pHead && _pHead->wakeTime_us <= now_us) {
-		        HwTimer* fired = _pHead;
-		        _pHead = _pHead->pNext;
-		        fired->pNext = nullptr;
-		        if (out.tail) out.tail->pNext = fired; else out.head = fired;
+		// A start or stop, with its times in cycles, ready to be applied to the queue.
+		struct TimerCommand
+		{
+			enum class Type : uint8_t { Start, Stop };
+
+			uint64_t wakeTime;
+			uint64_t sleepTime;
+			uint32_t slack;
+			TimerHandle hTimer;
+			Type type;
+			bool bPeriodic;
+			PeriodMode periodMode;
+			OverrunPolicy overrunPolicy;
+		};
+
+#ifdef CRT_TIMERS_COMMAND_QUEUE
+		MpscRing<TimerCommand, TIMERS_COMMAND_QUEUE_SIZE> _commandRing; // consumed by the timer interrupt only.
+#endif
+
+		// Pops all timers from the head with wakeTime <= now. That includes all timers with
+		// a deadline <= now. Timers further on with a passed wakeTime, behind one with a
+		// future wakeTime, simply wait for a later fire (still before their deadline).
+		void collectDueTimers(uint64_t now, FiredList& out) {
+		    HwTimer* first;
+		    while ((first = _timerQueue.getFirst()) && first->wakeTime <= now) {
+		        HwTimer* fired = _timerQueue.popFirst();
+		        if (fired->getQueueKey() > now) _nofCoalescedFires++;
+#ifdef CRT_TIMER_STATISTICS
+		        uint64_t lateness = now - fired->wakeTime;
+		        fired->stats.addFire((lateness > UINT32_MAX) ? UINT32_MAX : (uint32_t)lateness);
+#endif
+		        fired->pNextFired = nullptr;
+		        if (out.tail) out.tail->pNextFired = fired; else out.head = fired;
 		        out.tail = fired;
 		    }
+		    _timerQueue.advance(now);
 		}
 
 		void runCallbacks(FiredList& fired) {
-		    for (HwTimer* t = fired.head; t; t = t->pNext)
+		    for (HwTimer* t = fired.head; t; t = t->pNextFired)
 		        if (t->callback) t->callback(t->userArg);
 		}
 
-		void reschedulePeriodicsAndRearm(FiredList& fired, uint64_t now_us) {
+		void reschedulePeriodicsAndRearm(FiredList& fired, uint64_t now) {
 		    bool headChanged = false;
-		    for (HwTimer* t = fired.head; t; t = t->pNext) {
+		    for (HwTimer* t = fired.head; t; t = t->pNextFired) {
 		        if (t->bPeriodic && t->bRunning) {
-		            // t->wakeTime_us += (uint64_t)t->sleepTime_us;
-		        	// Nee, beter onderstaande.
-		        	// Liever gespreid een vertraging dan onregelmatiger perioden.
-		        	t->wakeTime_us = now_us + (uint64_t)t->sleepTime_us;
-		            headChanged |= insertTimerAtWakeUpTimeInList(*t);
+		        	if (t->periodMode == PeriodMode::FixedRate) {
+		        		rescheduleFixedRate(*t, now);
+		        	} else {
+		        		// t->wakeTime += t->sleepTime;
+		        		// Nee, beter onderstaande.
+		        		// Liever gespreid een vertraging dan onregelmatiger perioden.
+		        		t->wakeTime = now + t->sleepTime;
+		        	}
+		            headChanged |= _timerQueue.insert(*t);
 		        } else {
 		            t->bRunning = false;
 		        }
 		    }
 
 		    if (headChanged || _hTimerHardwareActivatedFor == TimerHandle_None) {
-		        reassignHardwareTimerInterruptToFirstInList(now_us);
+		        reassignHardwareTimerInterruptToFirstInList(now);
 		    }
 		}
 
 
-		// Precondition: critical section opened.
-		void removeFromList(TimerHandle hTimer) {
-		    HwTimer* curr = _pHead;
-		    HwTimer* prev = nullptr;
-		    while (curr) {
-		        if (curr->hTimer == hTimer) {
-		            if (prev) {prev->pNext = curr->pNext;}
-		            else {_pHead = curr->pNext;} // head verwijderen. ..dit verandert de head ook..
-		            curr -> pNext=nullptr; // tbv debug-overzicht
-		            return;
+		void rescheduleFixedRate(HwTimer& t, uint64_t now) {
+		    uint64_t next = t.wakeTime + t.sleepTime;
+		    if (next <= now) {
+		        // Overrun: the next period boundary has passed already.
+		        if (t.overrunPolicy == OverrunPolicy::Skip) {
+		            // (division only in this exceptional case)
+		            uint64_t nofMissed = (now - next) / t.sleepTime + 1;
+		            next += nofMissed * t.sleepTime;
+		            t.nofOverruns += (uint32_t)nofMissed;
+		        } else {
+		            // CatchUp: fires again right away. Counted once per missed period.
+		            t.nofOverruns++;
 		        }
-		        prev = curr;
-		        curr = curr->pNext;
-		    }
-		}
-
-		// returnvalue: headchanged
-		bool insertTimerAtWakeUpTimeInList(HwTimer& timer) {
-		    if (_pHead == nullptr) { _pHead = &timer; timer.pNext = nullptr; return true; }
-
-		    if (timer.wakeTime_us < _pHead->wakeTime_us) {
-		        timer.pNext = _pHead;
-		        _pHead = &timer;
-		        return true;
-		    }
-		    HwTimer* prev = _pHead;
-		    HwTimer* curr = _pHead->pNext;
-		    while (curr && !(timer.wakeTime_us < curr->wakeTime_us)) {
-		        prev = curr;
-		        curr = curr->pNext;
 		    }
-		    prev->pNext = &timer;
-		    timer.pNext = curr;
-		    return false;
+		    t.wakeTime = next;
 		}
 
-
 		// Precondition: critical section opened.
-		void reassignHardwareTimerInterruptToFirstInList(uint64_t now_us)
+		void reassignHardwareTimerInterruptToFirstInList(uint64_t now)
 		{
-		    if (_pHead == nullptr) {
-		        timer2_pause();
+		    HwTimer* first = _timerQueue.getFirst();
+		    if (first == nullptr) {
+		        disarmHwTimer();
 		        _hTimerHardwareActivatedFor = TimerHandle_None;
 		        return;
 		    }
-		    _hTimerHardwareActivatedFor = _pHead->hTimer;
+		    _hTimerHardwareActivatedFor = first->hTimer;
 
 		    // save few mics drag for next firing.. but at by loading
 		    // the mcu extra by calling below .. is it worth it?
 		    // from latest tests (DemoMultiTimer_WaitAny), I think its not.
-		    // now_us = Time::instance()->getTimeMicroseconds();
-		    uint64_t delta64 = (_pHead->wakeTime_us > now_us)
-		                     ? (_pHead->wakeTime_us - now_us)
-		                     : 1;
-		    uint32_t time_us = (delta64 > UINT32_MAX) ? UINT32_MAX : (uint32_t)delta64;
-		    timer2_fire_after_us(time_us);
+		    // now = getTotalCycleCount();
+		    uint64_t deadline = first->getQueueKey();
+		    uint64_t delta64 = (deadline > now)
+		                     ? (deadline - now)
+		                     : 0;
+		    armHwTimer(cyclesToHwUs(delta64));
+		}
+
+		// The time base: the cycles in which all times are kept (see HW_TIMER::getTimeBaseCount).
+		static inline uint64_t getTotalCycleCount()
+		{
+		    return HW_TIMER::getTimeBaseCount();
 		}
 
+		// Conversion of a delta in cycles to microseconds, for the hardware timer only.
+		// A 32 bit division (no 64 bit division in the ISR). Rounded up: never fires early.
+		// Deltas beyond UINT32_MAX cycles (tens of seconds) are capped: after such an early fire,
+		// the hardware timer is simply rearmed for the remainder. That is how deadlines of any
+		// length are handled: only the programming of the hardware timer is capped.
+		// A time base below 1MHz is the counter of the hardware timer itself (bOwnTimeBase). Then
+		// the delta is rounded down to microseconds, which the backend rounds up to exactly the
+		// same counts again (rounding up twice would add a count).
+		inline uint32_t cyclesToHwUs(uint64_t delta_cycles)
+		{
+		    if (_cyclesPerUs == 0)
+		    {
+		        constexpr uint64_t maxDelta_cycles = 1u << 26; // delta * _usPerCycle_q32 fits in 64 bits.
+		        uint64_t delta = (delta_cycles > maxDelta_cycles) ? maxDelta_cycles : delta_cycles;
+		        return (uint32_t)((delta * _usPerCycle_q32) >> 32);
+		    }
+		    uint32_t delta32 = (delta_cycles > UINT32_MAX) ? UINT32_MAX : (uint32_t)delta_cycles;
+		    return (delta32 / _cyclesPerUs) + (((delta32 % _cyclesPerUs) != 0) ? 1 : 0);
+		}
+
+		// Conversions at the API boundary (task context).
+		// Whole seconds and the remainder are converted apart, so long durations don't overflow.
+		// Rounded up: a duration is never shortened.
+		inline uint64_t usToCycles(uint64_t time_us)
+		{
+		    if (_bWholeMHz) return time_us * _cyclesPerUs;
+		    return (time_us / 1000000) * _countFrequency_Hz + ((time_us % 1000000) * _countFrequency_Hz + 999999) / 1000000;
+		}
+
+		inline uint64_t cyclesToUs(uint64_t cycles)
+		{
+		    return (cycles / _countFrequency_Hz) * 1000000 + (cycles % _countFrequency_Hz) * 1000000 / _countFrequency_Hz;
+		}
+
+		// Call from task context. The frequency of the time base changes only when the clock is reconfigured.
+		inline void updateClockIfChanged()
+		{
+		    uint32_t frequency = HW_TIMER::getTimeBaseFrequency();
+		    if (frequency == _countFrequency_Hz) return;
+		    _countFrequency_Hz = frequency;
+		    _cyclesPerUs  = _countFrequency_Hz / 1000000; // rounded down: cyclesToHwUs rounds up.
+		    _bWholeMHz    = ((_countFrequency_Hz % 1000000) == 0);
+		    if (_cyclesPerUs == 0)
+		    {
+		        assert(HW_TIMER::bOwnTimeBase); // see cyclesToHwUs.
+		        _usPerCycle_q32 = (1000000ull << 32) / _countFrequency_Hz;
+		    }
+		}
+
+		// Hardware timer access. For a free running backend, the critical sections suffice to
+		// keep its interrupt out (its priority is below configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY),
+		// so pause and resume are empty.
+	public:
+		static constexpr uint32_t defaultMaxHwDelta_us = HW_TIMER::maxDelta_us;
+	private:
+
+		inline void armHwTimer(uint32_t delta_us)
+		{
+		    if (delta_us > _maxHwDelta_us) delta_us = _maxHwDelta_us;
+		    HW_TIMER::fireAfter_us(delta_us);
+		}
+		inline void disarmHwTimer() { HW_TIMER::cancel(); }
+		inline void pauseHwTimer()  { HW_TIMER::pause(); }
+		inline void resumeHwTimer() { HW_TIMER::resume(); }
 
 	public:
-		Timers_template():_pHead(nullptr),_hTimerHardwareActivatedFor(TimerHandle_None)
+		Timers_template():_timerQueue(),_hTimerHardwareActivatedFor(TimerHandle_None),
+			_nofHwTimerInterrupts(0), _nofCoalescedFires(0),
+			_engineOverhead_us(0), _timerOverhead_us(defaultTimerOverhead_us), _bCalibrated(false),
+			_countFrequency_Hz(0), _cyclesPerUs(1), _usPerCycle_q32(0), _bWholeMHz(true), _maxHwDelta_us(defaultMaxHwDelta_us)
+#ifdef CRT_TIMERS_MEASURE_ISR
+			, _isrCyclesMax(0), _isrCyclesTotal(0), _nofIsrMeasured(0)
+#endif
 		{
-			timer2_init();
-			timer2_set_callback(timerCallback, this);
+			updateClockIfChanged();
+
+			HW_TIMER::init(timerCallback, this);
 
 			for (int hTimer=0; hTimer<MAX_NOF_TIMERS; hTimer++)
 			{
 				HwTimer& timer = _arTimers[hTimer];
-				timer.pNext = nullptr;
+				timer.pNextFired = nullptr;
 				timer.hTimer = hTimer;
 				timer.bRunning = false;
 			}
 		}
 
-		// callback for hw timer2:
+		// callback for the hardware timer (HW_TIMER):
 		inline static void timerCallback(void* userData)
 		{
 			Timers_template* pStmTimers = (Timers_template*)userData; // TODO gebruik Timers::instance, dan heeft deze timercallback geen argument meer nodig
@@ -214,14 +492,190 @@ namespace crt
 			Timers_template::instance().stopTimer_impl(hTimer);
 		}
 
-		inline static void startTimer(TimerHandle hTimer, uint32_t duration_us, bool bPeriodic)
+		// periodMode and overrunPolicy only apply if bPeriodic==true.
+		// slack_us: the timer may fire up to slack_us late, to share an interrupt with other timers.
+		// duration_us may exceed the range of the hardware timer (see setMaxHwDelta_us).
+		inline static void startTimer(TimerHandle hTimer, uint64_t duration_us, bool bPeriodic,
+		                              PeriodMode periodMode = PeriodMode::FixedDelay,
+		                              OverrunPolicy overrunPolicy = OverrunPolicy::Skip,
+		                              uint32_t slack_us = 0)
+		{
+			TimerStartRequest request(hTimer, duration_us, bPeriodic, periodMode, overrunPolicy, slack_us);
+			Timers_template::instance().startTimers_impl(&request, 1, true /*bHandlePendingWakeups*/);
+		}
+
+		// Starts several timers at once: the time is read once (all timers share the same
+		// reference instant), they are inserted in a single critical section, and the
+		// hardware timer is reprogrammed once. Timers that were running, are restarted.
+		// (see also TimerGroup in crt_Timer.h)
+		inline static void startTimers(const TimerStartRequest* arRequests, uint32_t nofRequests)
+		{
+			Timers_template::instance().startTimers_impl(arRequests, nofRequests, true /*bHandlePendingWakeups*/);
+		}
+
+		template <size_t NOF_REQUESTS>
+		inline static void startTimers(const TimerStartRequest (&arRequests)[NOF_REQUESTS])
+		{
+			startTimers(arRequests, (uint32_t)NOF_REQUESTS);
+		}
+
+		// Time until the hardware timer interrupt for the first running timer (its deadline,
+		// see slack), in microseconds. 0 if it is due already. UINT64_MAX if no timer is running.
+		// Used by tickless idle (see crt_TicklessIdle.cpp).
+		inline static uint64_t getTimeUntilNextDeadline_us()
+		{
+			return Timers_template::instance().getTimeUntilNextDeadline_us_impl();
+		}
+
+		// Conversion of cycles of the time base of Timers (f.e. of TimerStats) to microseconds.
+		// The cpu cycles of Time, unless the backend has a time base of its own (LPTIM1).
+		inline static uint64_t cyclesToMicroseconds(uint64_t cycles)
+		{
+			return Timers_template::instance().cyclesToUs(cycles);
+		}
+
+		// Amount of missed periods of a FixedRate timer, since it was started.
+		inline static uint32_t getOverrunCount(TimerHandle hTimer)
+		{
+			return Timers_template::instance().getOverrunCount_impl(hTimer);
+		}
+
+		// For tests of long timers: caps every programming of the hardware timer at maxHwDelta_us,
+		// so that long deadlines are reached via several rearms, without waiting for hours.
+		// Restore with setMaxHwDelta_us(Timers::defaultMaxHwDelta_us).
+		inline static void setMaxHwDelta_us(uint32_t maxHwDelta_us)
+		{
+			assert(maxHwDelta_us >= minimumWaitTimeUs);
+			Timers_template::instance()._maxHwDelta_us = maxHwDelta_us;
+		}
+
+		inline static uint32_t getMaxHwDelta_us()
+		{
+			return Timers_template::instance()._maxHwDelta_us;
+		}
+
+		// Amount of hardware timer interrupts handled so far.
+		inline static uint32_t getNofHwTimerInterrupts()
+		{
+			return Timers_template::instance()._nofHwTimerInterrupts;
+		}
+
+		// Amount of fires that took place before the deadline of the timer, along with another
+		// timer (thanks to slack). Each of those would otherwise have caused an interrupt of its own.
+		inline static uint32_t getNofCoalescedFires()
+		{
+			return Timers_template::instance()._nofCoalescedFires;
+		}
+
+		// Overhead compensations (see TimerCalibration). Until isCalibrated(), defaults are returned.
+		inline static uint32_t getEngineOverhead_us()
+		{
+			return Timers_template::instance()._engineOverhead_us;
+		}
+
+		inline static uint32_t getTimerOverhead_us()
 		{
-			Timers_template::instance().startTimer_impl(hTimer, duration_us, bPeriodic, true /*bHandlePendingWakeups*/);
+			return Timers_template::instance()._timerOverhead_us;
 		}
 
-		inline static uint32_t getMemUsageBytes()
+		inline static bool isCalibrated()
 		{
-			return Timers_template::instance().getMemUsageBytes_impl();
+			return Timers_template::instance()._bCalibrated;
+		}
+
+		// Normally only called by TimerCalibration.
+		inline static void setOverheads(uint32_t engineOverhead_us, uint32_t timerOverhead_us, bool bCalibrated)
+		{
+			Timers_template& timers = Timers_template::instance();
+			timers._engineOverhead_us = engineOverhead_us;
+			timers._timerOverhead_us  = timerOverhead_us;
+			timers._bCalibrated       = bCalibrated;
+		}
+
+#ifdef CRT_TIMERS_MEASURE_ISR
+		// Duration of the timer interrupt handling (handleHwTimerInterrupt), in cpu cycles.
+		inline static void getIsrDurationCycles(uint32_t& max, uint32_t& avg, uint32_t& nofMeasured)
+		{
+			Timers_template& timers = Timers_template::instance();
+			taskENTER_CRITICAL();
+			max = timers._isrCyclesMax;
+			nofMeasured = timers._nofIsrMeasured;
+			avg = (nofMeasured == 0) ? 0 : (uint32_t)(timers._isrCyclesTotal / nofMeasured);
+			taskEXIT_CRITICAL();
+		}
+
+		inline static void resetIsrDurationCycles()
+		{
+			Timers_template& timers = Timers_template::instance();
+			taskENTER_CRITICAL();
+			timers._isrCyclesMax = 0;
+			timers._isrCyclesTotal = 0;
+			timers._nofIsrMeasured = 0;
+			taskEXIT_CRITICAL();
+		}
+#endif
+
+#ifdef CRT_TIMER_STATISTICS
+		// Copy of the statistics of a timer (consistent: taken in a critical section).
+		inline static void getStats(TimerHandle hTimer, TimerStats& stats)
+		{
+			Timers_template& timers = Timers_template::instance();
+			assert(timers._indexPoolTimerCreation.isIndexUsed(hTimer));
+			taskENTER_CRITICAL();
+			stats = timers._arTimers[hTimer].stats;
+			taskEXIT_CRITICAL();
+		}
+
+		inline static void resetStats(TimerHandle hTimer)
+		{
+			Timers_template& timers = Timers_template::instance();
+			assert(timers._indexPoolTimerCreation.isIndexUsed(hTimer));
+			taskENTER_CRITICAL();
+			timers._arTimers[hTimer].stats.reset();
+			taskEXIT_CRITICAL();
+		}
+
+		// Prints the statistics of all timers in use, lateness in us.
+		static void dumpStats()
+		{
+			Timers_template& timers = Timers_template::instance();
+			printf("Timer statistics (lateness in us; histogram buckets: <2^%lu cycles, then x2 each):\r\n",
+			       TimerStats::FIRST_BUCKET_BITS);
+			for (int32_t hTimer = 0; hTimer < MAX_NOF_TIMERS; hTimer++) // (int32_t: TimerHandle may be too small to pass the end)
+			{
+				if (!timers._indexPoolTimerCreation.isIndexUsed(hTimer)) continue;
+
+				TimerStats stats;
+				getStats(hTimer, stats);
+				if (stats.nofFires == 0) continue;
+
+				printf("  %-16s fires %lu, min %lu, mean %lu, max %lu, hist",
+				       timers.getName(hTimer),
+				       stats.nofFires,
+				       (uint32_t)timers.cyclesToUs(stats.minLateness),
+				       (uint32_t)timers.cyclesToUs(stats.totalLateness / stats.nofFires),
+				       (uint32_t)timers.cyclesToUs(stats.maxLateness));
+				for (uint32_t count : stats.arHistogram)
+				{
+					printf(" %lu", count);
+				}
+				printf("\r\n");
+			}
+		}
+#endif
+
+		// RAM used by Timers: all of it is preallocated, so it is known at compile time
+		// (see CRT_TIMERS_RAM_BUDGET_BYTES in crt_Config.h). Per timer, it is about getMemUsagePerTimerBytes.
+		static constexpr uint32_t getMemUsageBytes()
+		{
+			return (uint32_t)sizeof(Timers_template);
+		}
+
+		// The part of getMemUsageBytes that every timer of MAX_NOF_TIMERS costs.
+		// (without the per timer part of the queue engine, see crt_Timers_template)
+		static constexpr uint32_t getMemUsagePerTimerBytes()
+		{
+			return (uint32_t)(sizeof(HwTimer) + 2 * sizeof(TimerHandle)); // the timer and its entries in the index pool.
 		}
 
 		inline static uint32_t getMaxNofTimers()
@@ -239,6 +693,20 @@ namespace crt
 			return Timers_template::instance().getNofTimersInUse_impl();
 		}
 
+		// The name passed at createTimer ("?" if none, or if CRT_TIMER_NO_NAMES is defined).
+		inline static const char* getName(TimerHandle hTimer)
+		{
+#ifndef CRT_TIMER_NO_NAMES
+			Timers_template& timers = Timers_template::instance();
+			assert(timers._indexPoolTimerCreation.isIndexUsed(hTimer));
+			const char* name = timers._arTimers[hTimer].name;
+			return (name != nullptr) ? name : "?";
+#else
+			(void)hTimer;
+			return "?";
+#endif
+		}
+
 	private:
 		[[nodiscard]] TimerHandle createTimer_impl(const char* name, TimerArgsCallback callback, void* userArg)
 		{
@@ -253,72 +721,165 @@ namespace crt
 
 			HwTimer& timer = _arTimers[hTimer];
 
+#ifndef CRT_TIMER_NO_NAMES
 			timer.name 		= name;
+#else
+			(void)name;
+#endif
 			timer.callback 	= callback;
 			timer.userArg   = userArg;
 			timer.bPeriodic = false; // is passed and set at startTimer(), rather than at construction time.
 			timer.bRunning	= false;
-			timer.sleepTime_us = 0;
-			timer.wakeTime_us = 0;
-			timer.pNext = nullptr;
+			timer.sleepTime = 0;
+			timer.wakeTime = 0;
+			timer.slack = 0;
+			timer.nofOverruns = 0;
+			timer.periodMode = PeriodMode::FixedDelay;
+			timer.overrunPolicy = OverrunPolicy::Skip;
+			timer.pNextFired = nullptr;
+#ifdef CRT_TIMER_STATISTICS
+			timer.stats.reset();
+#endif
 
 			return hTimer;
 		}
 
-		inline void startTimer_impl(TimerHandle hTimer, uint32_t duration_us_in, bool bPeriodic, bool bHandleWakeups)
+		// Task context: converts the request to a command, with the times in cycles.
+		inline TimerCommand makeStartCommand(const TimerStartRequest& request, uint64_t now)
 		{
-			assert(_indexPoolTimerCreation.isIndexUsed(hTimer));
-
-			// zonder gcc en g++ compiler optimizations (O0):
-			// uint32_t estimated_overhead_us = uint64_t(SystemCoreClock)/4400000; // Bij 84Mhz clock: 84M/1M = 84, maar delay is 19, dus nog eens delen door factor 84/19=4.4
-
-			// met gcc en g++ compiler optimizations (O2):
-			//uint32_t estimated_overhead_us = uint64_t(SystemCoreClock)/10000000;
+			// De overhead hangt af van clock en compiler optimizations (bij 16MHz en O0 wel 150us oid).
+			// Daarom wordt hij bij het opstarten gemeten (TimerCalibration), ipv geschat.
+			uint64_t estimated_overhead_us = _engineOverhead_us;
+			uint64_t duration_us = (request.duration_us > estimated_overhead_us) ? (request.duration_us - estimated_overhead_us) : 1;
+
+			uint64_t duration   = usToCycles(duration_us);
+			uint64_t period     = usToCycles(request.duration_us);
+			uint64_t slack64    = usToCycles(request.slack_us);
+
+			TimerCommand command;
+			command.type          = TimerCommand::Type::Start;
+			command.hTimer        = request.hTimer;
+			command.bPeriodic     = request.bPeriodic;
+			command.periodMode    = request.periodMode;
+			command.overrunPolicy = request.overrunPolicy;
+			command.wakeTime      = now + duration + usToCycles(request.offset_us);
+			// A time base below 1MHz (LPTIM1): now is the start of its current count, which began up
+			// to a count ago. One count extra, so the first wake is never early.
+			if (_cyclesPerUs == 0) command.wakeTime += 1;
+			// FixedRate: only the first wake is compensated. The period itself must be exact.
+			command.sleepTime     = (request.bPeriodic && (request.periodMode == PeriodMode::FixedRate)) ? period : duration;
+			command.slack         = (slack64 > UINT32_MAX) ? UINT32_MAX : (uint32_t)slack64; // max tens of seconds.
+			return command;
+		}
 
-			// Automatisch aanpassen:
-			/* In een header of bronbestand dat zowel met gcc als g++ wordt gecompileerd, wordt die OPTIMIZE gezet als niet O0 */
-			#if defined(__OPTIMIZE__) && !defined(__OPTIMIZE_SIZE__)
-			  /* -O1, -O2 of -O3 */
-			  #define EST_OVERHEAD_DIV 10000000ULL
-			#else
-			  /* -O0 */
-			  #define EST_OVERHEAD_DIV 4400000ULL
-			#endif
+		// Precondition: critical section opened (or in the timer interrupt).
+		// Returns true if the hardware timer may need to be reassigned.
+		inline bool applyCommand(const TimerCommand& command)
+		{
+			HwTimer& timer = _arTimers[command.hTimer];
+			bool headChanged = false;
 
-			// Bij 16MHZ moet EST_OVERHEAD_DIV weer opnieuw getweakt worden.
-			// Vooral bij O0 is dan de overhead enorm (150us oid).
+			if(timer.bRunning)
+			{
+				// Remove current wakeup time for this timer.
+				timer.bRunning = false;
+				_timerQueue.remove(timer);
+				if (command.hTimer == _hTimerHardwareActivatedFor) headChanged = true;
+			}
 
-			uint32_t estimated_overhead_us = 0;//(uint32_t)((uint64_t)SystemCoreClock / EST_OVERHEAD_DIV);
+			if (command.type == TimerCommand::Type::Start)
+			{
+				timer.bPeriodic     = command.bPeriodic;
+				timer.periodMode    = command.periodMode;
+				timer.overrunPolicy = command.overrunPolicy;
+				timer.nofOverruns   = 0;
+				timer.wakeTime      = command.wakeTime;
+				timer.sleepTime     = command.sleepTime;
+				timer.slack         = command.slack;
+				timer.bRunning      = true;
+
+				headChanged |= _timerQueue.insert(timer);
+			}
+			return headChanged;
+		}
 
-			assert(duration_us_in>estimated_overhead_us);
-			uint32_t duration_us = duration_us_in - estimated_overhead_us;
+#ifdef CRT_TIMERS_COMMAND_QUEUE
+		// Returns the ticket of the command (see waitUntilApplied).
+		// A slot is claimed and published with the scheduler suspended (interrupts stay enabled).
+		// Otherwise, a task that is preempted in between would hold up the timer interrupt at its
+		// slot (see crt_MpscRing.h), and a task of higher priority that spins below would starve it.
+		inline uint32_t postCommand(const TimerCommand& command)
+		{
+			uint32_t ticket = 0;
+			while (true)
+			{
+				vTaskSuspendAll();
+				bool bPushed = _commandRing.tryPush(command, ticket);
+				xTaskResumeAll();
+				if (bPushed) return ticket;
 
-			HwTimer& timer = _arTimers[hTimer];
+				// Full: the timer interrupt empties it. (it preempts the task right away)
+				HW_TIMER::triggerSoftwareInterrupt();
+			}
+		}
 
-			if(timer.bRunning)
+		// Spins for the timer interrupt only: all slots up to the ticket are published (see
+		// postCommand), so it pops them as soon as it runs.
+		inline void waitUntilApplied(uint32_t ticket)
+		{
+			while (!_commandRing.isPopped(ticket))
 			{
-				stopTimer_impl(hTimer); // Remove current wakeup time for this timer.
+				HW_TIMER::triggerSoftwareInterrupt(); // normally, it has been applied already.
 			}
+		}
 
-			timer.bPeriodic   = bPeriodic;
+		// Timer interrupt only.
+		inline void applyPostedCommands()
+		{
+			TimerCommand command;
+			while (_commandRing.tryPop(command))
+			{
+				assert(_indexPoolTimerCreation.isIndexUsed(command.hTimer));
+				applyCommand(command);
+			}
+		}
 
-			uint64_t now_us   = Time::instance()->getTimeMicroseconds();
-			timer.wakeTime_us = now_us + int64_t(duration_us);
-			timer.sleepTime_us = duration_us;
-			timer.bRunning = true;
+		inline void startTimers_impl(const TimerStartRequest* arRequests, uint32_t nofRequests, bool /*bHandleWakeups*/)
+		{
+			// Below, everything is in cycles: no conversions in the ISR.
+			updateClockIfChanged();
 
-			//bool bNewlyHwTimerStartNeeded = false;
+			uint64_t now = getTotalCycleCount(); // the reference instant of all requests.
+			for (uint32_t i = 0; i < nofRequests; i++)
+			{
+				assert(_indexPoolTimerCreation.isIndexUsed(arRequests[i].hTimer));
+				postCommand(makeStartCommand(arRequests[i], now));
+			}
+			HW_TIMER::triggerSoftwareInterrupt(); // the timer interrupt applies them, and handles due wakeups.
+		}
+#else
+		inline void startTimers_impl(const TimerStartRequest* arRequests, uint32_t nofRequests, bool bHandleWakeups)
+		{
+			// Below, everything is in cycles: no conversions in the ISR.
+			updateClockIfChanged();
 
-			timer2_pause();
+			pauseHwTimer();
 			taskENTER_CRITICAL();
-			bool headChanged = insertTimerAtWakeUpTimeInList(timer);
+			uint64_t now = getTotalCycleCount(); // the reference instant of all requests.
+			bool headChanged = false;
+
+			for (uint32_t i = 0; i < nofRequests; i++)
+			{
+				assert(_indexPoolTimerCreation.isIndexUsed(arRequests[i].hTimer));
+				headChanged |= applyCommand(makeStartCommand(arRequests[i], now));
+			}
 
 			FiredList fired;
 			if (bHandleWakeups) {
-			    collectDueTimers(now_us, fired);
+			    collectDueTimers(now, fired);
 			}
 			if (headChanged || fired.head) {
-			    reassignHardwareTimerInterruptToFirstInList(now_us);
+			    reassignHardwareTimerInterruptToFirstInList(now);
 			}
 			bool needResume = (_hTimerHardwareActivatedFor != TimerHandle_None);
 			taskEXIT_CRITICAL();
@@ -326,26 +887,50 @@ namespace crt
 			runCallbacks(fired);
 
 			taskENTER_CRITICAL();
-			reschedulePeriodicsAndRearm(fired, now_us);
+			reschedulePeriodicsAndRearm(fired, now);
 			needResume = (_hTimerHardwareActivatedFor != TimerHandle_None);
 			taskEXIT_CRITICAL();
 
-			if (needResume) timer2_resume();
+			if (needResume) resumeHwTimer();
 		}
+#endif
 
+#ifdef CRT_TIMERS_COMMAND_QUEUE
 		inline void stopTimer_impl(TimerHandle hTimer)
 		{
-			timer2_pause();
+			assert(_indexPoolTimerCreation.isIndexUsed(hTimer));
+			TimerCommand command = {};
+			command.type   = TimerCommand::Type::Stop;
+			command.hTimer = hTimer;
+			uint32_t ticket = postCommand(command);
+			HW_TIMER::triggerSoftwareInterrupt();
+			waitUntilApplied(ticket);
+		}
+
+		void destroyTimer_impl(TimerHandle hTimer)
+		{
+			assert(_indexPoolTimerCreation.isIndexUsed(hTimer));
+			stopTimer_impl(hTimer); // after this, the timer interrupt does not use it anymore.
+
+			taskENTER_CRITICAL(); // for the index pool only.
+			_indexPoolTimerCreation.releaseIndex(hTimer); // Index can be reused at new createTimer call in the future.
+			_arTimers[hTimer].reset();
+			taskEXIT_CRITICAL();
+		}
+#else
+		inline void stopTimer_impl(TimerHandle hTimer)
+		{
+			pauseHwTimer();
 			taskENTER_CRITICAL();
 			assert(_indexPoolTimerCreation.isIndexUsed(hTimer));
 
 			// invariance: running timer <-> in the list.
 			_arTimers[hTimer].bRunning = false; // Unmark it as running
-			removeFromList(hTimer); // Kan langer duren bij veel timers.
+			_timerQueue.remove(_arTimers[hTimer]); // Kan langer duren bij veel timers (afhankelijk van TIMER_QUEUE).
 
-			uint64_t now_us = Time::instance()->getTimeMicroseconds();
+			uint64_t now = getTotalCycleCount();
 			FiredList fired;
-			collectDueTimers(now_us, fired);
+			collectDueTimers(now, fired);
 			taskEXIT_CRITICAL();
 
 			runCallbacks(fired); // volgens cgpt veiligst om niet binnen task crit aan
@@ -355,19 +940,19 @@ namespace crt
 
 			taskENTER_CRITICAL();
 			//bool bWakeupHandled = handleWakeups(now_us);
-			reschedulePeriodicsAndRearm(fired, now_us);
+			reschedulePeriodicsAndRearm(fired, now);
 
 			bool needResume = (_hTimerHardwareActivatedFor != TimerHandle_None);
 			taskEXIT_CRITICAL();
 
 			//runCallbacksAndReschedule(fired, now_us);
 
-			if (needResume) timer2_resume();
+			if (needResume) resumeHwTimer();
 		}
 
-		// Typically, crt_StmTimers is used by crt::Task to act on behave of crt::HwTimer objects.
-		// In that case, the function below should never be called,
-		// because all Tasks and associated timers are normally instantiated at device startup and never destroyed.
+		// Typically, crt_StmTimers is used by crt::Task to act on behave of crt::HwTimer objects,
+		// which are instantiated at device startup and never destroyed. But the calibration
+		// (crt_TimerCalibration.h) destroys its timers at startup, while others may run already.
 		void destroyTimer_impl(TimerHandle hTimer)
 		{
 			assert(_indexPoolTimerCreation.isIndexUsed(hTimer));
@@ -379,7 +964,7 @@ namespace crt
 			_arTimers[hTimer].reset();
 
 			FiredList fired;
-		    uint64_t now_us = 0;
+		    uint64_t now = 0;
 		    bool needResume = false;
 
 			if(hTimer==_hTimerHardwareActivatedFor)
@@ -389,17 +974,16 @@ namespace crt
 
 			// perhaps there are other timers in the list.
 			// make sure that they are assigned and handled properly:
-			now_us   = Time::instance()->getTimeMicroseconds();
+			// (within the critical section, like stopTimer_impl: the timer interrupt runs meanwhile)
+			now   = getTotalCycleCount();
+			collectDueTimers(now, fired);
 
 			taskEXIT_CRITICAL();
 
-			//handleWakeups(now_us);
-			collectDueTimers(now_us, fired);
-
 			runCallbacks(fired);
 
 			taskENTER_CRITICAL();
-			reschedulePeriodicsAndRearm(fired, now_us);
+			reschedulePeriodicsAndRearm(fired, now);
 
 			needResume = (_hTimerHardwareActivatedFor != TimerHandle_None);
 
@@ -407,8 +991,9 @@ namespace crt
 
 			//runCallbacksAndReschedule(fired, now_us);
 
-			if (needResume) timer2_resume();
+			if (needResume) resumeHwTimer();
 		}
+#endif
 
 
 //		// return true if one or more were handled.
@@ -441,10 +1026,10 @@ namespace crt
 			return _arTimers[hTimer].bRunning;
 		}
 
-		bool handleWakeups2(uint64_t now_us)
+		bool handleWakeups2(uint64_t now)
 		{
 			FiredList fired;
-			collectDueTimers(now_us, fired);
+			collectDueTimers(now, fired);
 
 			runCallbacks(fired); // volgens cgpt veiligst om niet binnen task crit aan
 								 // te roepen, ivm mogelijke problemen als non-isr qualified
@@ -452,12 +1037,12 @@ namespace crt
 								 // zou poteniele latency ook beperken.
 
 			//bool bWakeupHandled = handleWakeups(now_us);
-			reschedulePeriodicsAndRearm(fired, now_us);
+			reschedulePeriodicsAndRearm(fired, now);
 
 			bool needResume = (_hTimerHardwareActivatedFor != TimerHandle_None);
 			//runCallbacksAndReschedule(fired, now_us);
 
-			if (needResume) timer2_resume();
+			if (needResume) resumeHwTimer();
 
 			return fired.head != nullptr;
 		}
@@ -471,28 +1056,58 @@ namespace crt
 			// timer2_pause - resume sections above.
 			// critical section not needed here either,
 			// because timer2_interrupt priority is higher than any allowed priority for CleanRTOS tasks.
-			uint64_t now_us   = Time::instance()->getTimeMicroseconds();
+#ifdef CRT_TIMERS_MEASURE_ISR
+			uint32_t isrStartCycles = getCycleCount();
+#endif
+			uint64_t now   = getTotalCycleCount(); // cycles: no 64 bit division needed.
+			_nofHwTimerInterrupts++;
+
+#ifdef CRT_TIMERS_COMMAND_QUEUE
+			applyPostedCommands();
+#endif
+			handleWakeups2(now);
+
+			// Always rearm: also if nothing was due yet (the hardware timer fired a bit early
+			// compared to Time). Otherwise the first timer would never fire.
+			reassignHardwareTimerInterruptToFirstInList(now);
+
+#ifdef CRT_TIMERS_MEASURE_ISR
+			// (the Time task, which resets the cycle counter, can't run during the ISR)
+			uint32_t isrCycles = getCycleCount() - isrStartCycles;
+			if (isrCycles > _isrCyclesMax) _isrCyclesMax = isrCycles;
+			_isrCyclesTotal += isrCycles;
+			_nofIsrMeasured++;
+#endif
+		}
 
-			bool bWakeupHandled = handleWakeups2(now_us);
-			if(bWakeupHandled)
-			{
-				reassignHardwareTimerInterruptToFirstInList(now_us);
-			}
+		inline uint32_t getMaxNofTimers_impl()
+		{
+			return (uint32_t)MAX_NOF_TIMERS;
 		}
 
-		inline uint32_t getMemUsageBytes_impl()
+		inline uint64_t getTimeUntilNextDeadline_us_impl()
 		{
-			return sizeof(*this);
+			taskENTER_CRITICAL();
+			HwTimer* first = _timerQueue.getFirst();
+			bool bRunning = (first != nullptr);
+			uint64_t deadline = bRunning ? first->getQueueKey() : 0;
+			uint64_t now = getTotalCycleCount();
+			taskEXIT_CRITICAL();
+
+			if (!bRunning) return UINT64_MAX;
+			if (deadline <= now) return 0;
+			return cyclesToUs(deadline - now);
 		}
 
-		inline uint32_t getMaxNofTimers_impl()
+		inline uint32_t getOverrunCount_impl(TimerHandle hTimer)
 		{
-			return (uint32_t)MAX_NOF_TIMERS;
+			assert(_indexPoolTimerCreation.isIndexUsed(hTimer));
+			return _arTimers[hTimer].nofOverruns;
 		}
 
 		inline bool isValidTimerHandle_impl(TimerHandle hTimer)
 		{
-			return _indexPoolTimerCreation.isIndexUsed(hTimer);
+			return (hTimer >= 0) && _indexPoolTimerCreation.isIndexUsed(hTimer); // (TimerHandle_None is -1)
 		}
 
 		// returns amount of timers that have been created and not yet destroyed.
@@ -0,0 +1,47 @@
+// Host simulation (see crt_Sim.h): replaces FreeRTOS.h (with FreeRTOSConfig.h) of the stm project.
+// Only the parts that CleanRTOS uses.
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdFALSE  ((BaseType_t)0)
+#define pdTRUE   ((BaseType_t)1)
+#define pdPASS   (pdTRUE)
+#define pdFAIL   (pdFALSE)
+
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+
+#define configTICK_RATE_HZ 1000
+#define configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY 5
+#define configASSERT(x) assert(x)
+
+// Critical sections mask the simulated interrupt (they nest). Leaving the outer one runs a
+// software trigger that came in meanwhile, like the NVIC would.
+void crt_sim_enter_critical(void);
+void crt_sim_exit_critical(void);
+UBaseType_t crt_sim_enter_critical_from_isr(void);
+void crt_sim_exit_critical_from_isr(UBaseType_t saved);
+
+#define taskENTER_CRITICAL()                crt_sim_enter_critical()
+#define taskEXIT_CRITICAL()                 crt_sim_exit_critical()
+#define taskENTER_CRITICAL_FROM_ISR()       crt_sim_enter_critical_from_isr()
+#define taskEXIT_CRITICAL_FROM_ISR(x)       crt_sim_exit_critical_from_isr(x)
+
+#define portYIELD_FROM_ISR(x)               ((void)(x))
+
+size_t xPortGetFreeHeapSize(void);
+
+#ifdef __cplusplus
+}
+#endif
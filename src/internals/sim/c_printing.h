@@ -0,0 +1,6 @@
+// Host simulation (see crt_Sim.h): replaces c_printing.h.
+
+#pragma once
+#include <stdio.h>
+
+#define safe_printf printf
@@ -0,0 +1,128 @@
+// Host simulation (see crt_Sim.h): replaces the CMSIS-RTOS2 api of the stm project.
+// Only the parts that CleanRTOS uses. Types and constants as in the real cmsis_os2.h.
+// Threads are not run (see crt_Sim.h). Event flags, message queues and mutexes work,
+// for a single thread plus the simulated interrupt: a wait that would block advances the
+// virtual clock from interrupt to interrupt.
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define osWaitForever         0xFFFFFFFFU
+
+#define osFlagsWaitAny        0x00000000U
+#define osFlagsWaitAll        0x00000001U
+#define osFlagsNoClear        0x00000002U
+
+#define osFlagsError          0x80000000U
+#define osFlagsErrorUnknown   0xFFFFFFFFU
+#define osFlagsErrorTimeout   0xFFFFFFFEU
+#define osFlagsErrorResource  0xFFFFFFFDU
+#define osFlagsErrorParameter 0xFFFFFFFCU
+#define osFlagsErrorISR       0xFFFFFFFAU
+
+typedef enum {
+	osOK                      =  0,
+	osError                   = -1,
+	osErrorTimeout            = -2,
+	osErrorResource           = -3,
+	osErrorParameter          = -4,
+	osErrorNoMemory           = -5,
+	osErrorISR                = -6,
+	osStatusReserved          = 0x7FFFFFFF
+} osStatus_t;
+
+typedef enum {
+	osKernelInactive        =  0,
+	osKernelReady           =  1,
+	osKernelRunning         =  2,
+	osKernelLocked          =  3,
+	osKernelSuspended       =  4,
+	osKernelError           = -1,
+	osKernelReserved        = 0x7FFFFFFF
+} osKernelState_t;
+
+typedef enum {
+	osPriorityNone          =  0,
+	osPriorityIdle          =  1,
+	osPriorityLow           =  8,
+	osPriorityBelowNormal   = 16,
+	osPriorityNormal        = 24,
+	osPriorityAboveNormal   = 32,
+	osPriorityHigh          = 40,
+	osPriorityRealtime      = 48,
+	osPriorityISR           = 56,
+	osPriorityError         = -1,
+	osPriorityReserved      = 0x7FFFFFFF
+} osPriority_t;
+
+typedef void (*osThreadFunc_t) (void *argument);
+typedef void *osThreadId_t;
+typedef void *osEventFlagsId_t;
+typedef void *osMessageQueueId_t;
+typedef void *osMutexId_t;
+
+typedef struct {
+	const char   *name;
+	uint32_t      attr_bits;
+	void         *cb_mem;
+	uint32_t      cb_size;
+	void         *stack_mem;
+	uint32_t      stack_size;
+	osPriority_t  priority;
+	uint32_t      tz_module;
+	uint32_t      reserved;
+} osThreadAttr_t;
+
+typedef struct {
+	const char   *name;
+	uint32_t      attr_bits;
+	void         *cb_mem;
+	uint32_t      cb_size;
+} osEventFlagsAttr_t;
+
+typedef struct {
+	const char   *name;
+	uint32_t      attr_bits;
+	void         *cb_mem;
+	uint32_t      cb_size;
+	void         *mq_mem;
+	uint32_t      mq_size;
+} osMessageQueueAttr_t;
+
+typedef struct {
+	const char   *name;
+	uint32_t      attr_bits;
+	void         *cb_mem;
+	uint32_t      cb_size;
+} osMutexAttr_t;
+
+osKernelState_t osKernelGetState(void);
+uint32_t osKernelGetTickCount(void);	// milliseconds of the virtual clock.
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr); // does not run func.
+osStatus_t osThreadYield(void);
+osStatus_t osDelay(uint32_t ticks);	// advances the virtual clock.
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t *attr);
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags);
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags);
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id);
+uint32_t osEventFlagsWait(osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout);
+
+osMessageQueueId_t osMessageQueueNew(uint32_t msg_count, uint32_t msg_size, const osMessageQueueAttr_t *attr);
+osStatus_t osMessageQueuePut(osMessageQueueId_t mq_id, const void *msg_ptr, uint8_t msg_prio, uint32_t timeout);
+osStatus_t osMessageQueueGet(osMessageQueueId_t mq_id, void *msg_ptr, uint8_t *msg_prio, uint32_t timeout);
+uint32_t osMessageQueueGetCount(osMessageQueueId_t mq_id);
+
+osMutexId_t osMutexNew(const osMutexAttr_t *attr);
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t timeout);
+osStatus_t osMutexRelease(osMutexId_t mutex_id);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,25 @@
+// Host simulation (see crt_Sim.h): replaces core_cm4.h, for stmCycleCounter.h.
+// The DWT cycle counter is a plain variable: it does not follow the virtual clock.
+// (so measurements with getCycleCount, like CRT_TIMERS_MEASURE_ISR, read 0 in the simulation)
+
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+	volatile uint32_t CTRL;
+	volatile uint32_t CYCCNT;
+} DWT_Type;
+
+extern DWT_Type crt_sim_dwt;
+
+#define DWT ((DWT_Type*)&crt_sim_dwt)
+#define DWT_CTRL_CYCCNTENA_Msk (1UL)
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+
+#include "crt_Sim.h"
+#include "crt_Time.h"
+#include "stmHwTimer2.h" // for TimerCallback
+
+namespace crt
+{
+	// Hardware timer backend for Timers_template in the host simulation (see crt_Sim.h).
+	// (for the interface, see crt_HwTimerBackend_Tim2.h)
+	// Like timer2 in free running mode: a microsecond counter and a compare deadline.
+	class HwTimerBackend_Sim
+	{
+	public:
+		static constexpr bool bFreeRunning = true;
+		static constexpr uint32_t maxDelta_us = 0x7FFFFFFF;
+
+		static inline void init(TimerCallback callback, void* userData)
+		{
+			crt_sim_hw_timer_set_callback(callback, userData);
+		}
+
+		static inline void fireAfter_us(uint32_t delta_us)
+		{
+			crt_sim_hw_timer_fire_at(crt_sim_now() + (uint64_t)delta_us * sim::COUNTS_PER_US);
+		}
+
+		static inline void cancel() { crt_sim_hw_timer_cancel(); }
+		static inline void pause()  {}
+		static inline void resume() {}
+
+		static constexpr bool bOwnTimeBase = false;
+		static inline uint64_t getTimeBaseCount() { return Time::getTotalCycleCount(); }
+		static inline uint32_t getTimeBaseFrequency() { return Time::getCountFrequency(); }
+
+		static inline void triggerSoftwareInterrupt() { crt_sim_hw_timer_trigger(); }
+	}; // end class HwTimerBackend_Sim
+}; // end namespace crt
@@ -0,0 +1,500 @@
+// Host simulation of the hardware under the timing of CleanRTOS (see crt_Sim.h).
+// The whole file is guarded with CRT_SIM: the stm project compiles all sources under src/internals.
+
+#ifdef CRT_SIM
+
+#include "crt_Sim.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cassert>
+#include <vector>
+
+extern "C" {
+	#include "crt_stm_hal.h"
+	#include "core_cm4.h"
+	#include "cmsis_os2.h"
+	#include "stmHwTimer5.h"
+}
+#include "FreeRTOS.h"
+#include "task.h"
+
+namespace crt
+{
+	namespace sim
+	{
+		namespace
+		{
+			uint64_t virtualClock = 0;
+
+			// The hardware timer: a single deadline and a software trigger, on one interrupt.
+			CrtSimCallback hwCallback = nullptr;
+			void* hwUserData = nullptr;
+			bool bArmed = false;
+			uint64_t deadline = 0;
+			bool bSoftwarePending = false;
+			uint32_t latency = 0;
+			uint32_t nofInterrupts = 0;
+			uint32_t nofDeadlineInterrupts = 0;
+
+			// Masking of the interrupt.
+			uint32_t primask = 0;
+			uint32_t criticalNesting = 0;
+			bool bInIsr = false;
+
+			uint32_t notifyCount = 0; // the (single) task notification value.
+			bool bNotifyPending = false; // a notification was given, that xTaskNotifyWait didn't take yet.
+			uint32_t nofKernelCalls = 0; // calls of the event flags, task notification and message queue functions.
+
+			inline bool isMasked()
+			{
+				return (primask != 0) || (criticalNesting != 0) || bInIsr;
+			}
+
+			inline uint64_t getFireTime()
+			{
+				return deadline + latency;
+			}
+
+			void runIsr()
+			{
+				bInIsr = true;
+				nofInterrupts++;
+				if (hwCallback != nullptr) hwCallback(hwUserData);
+				bInIsr = false;
+			}
+
+			// Runs the interrupt as long as it is pending, unless it is masked (then it runs
+			// when it is unmasked).
+			void runPendingInterrupts()
+			{
+				while (!isMasked())
+				{
+					if (bArmed && (getFireTime() <= virtualClock))
+					{
+						bArmed = false;
+						nofDeadlineInterrupts++;
+					}
+					else if (bSoftwarePending)
+					{
+						bSoftwarePending = false;
+					}
+					else
+					{
+						return;
+					}
+					runIsr();
+				}
+			}
+
+			// A wait that would block: advances to the next interrupt, until bReady returns true,
+			// or until limit (returns false then).
+			template<typename READY>
+			bool waitUntil(READY bReady, uint64_t limit)
+			{
+				assert(!isMasked()); // a wait from an ISR or a critical section would never end.
+				while (!bReady())
+				{
+					if (!runNextInterrupt(limit))
+					{
+						if (limit != UINT64_MAX)
+						{
+							advanceTo(limit);
+							return bReady();
+						}
+						fprintf(stderr, "crt::sim: deadlock: a wait would block forever (no hardware timer deadline armed) at %llu us\n",
+						        (unsigned long long)now_us());
+						abort();
+					}
+				}
+				return true;
+			}
+
+			uint64_t getLimit_ms(uint32_t timeout_ms)
+			{
+				if (timeout_ms == osWaitForever) return UINT64_MAX;
+				return virtualClock + (uint64_t)timeout_ms * (COUNT_FREQUENCY_HZ / 1000);
+			}
+
+			struct MessageQueue
+			{
+				std::vector<uint8_t> buffer;
+				uint32_t msgSize;
+				uint32_t capacity;
+				uint32_t head;
+				uint32_t count;
+			};
+		}; // end anonymous namespace
+
+		uint64_t now()
+		{
+			return virtualClock;
+		}
+
+		uint64_t now_us()
+		{
+			return virtualClock / COUNTS_PER_US;
+		}
+
+		void advanceTo(uint64_t count)
+		{
+			assert(!isMasked());
+			while (runNextInterrupt(count)) {}
+			if (count > virtualClock) virtualClock = count;
+		}
+
+		void advance_us(uint64_t duration_us)
+		{
+			advanceTo(virtualClock + duration_us * COUNTS_PER_US);
+		}
+
+		bool runNextInterrupt(uint64_t limit)
+		{
+			assert(!isMasked());
+			if (!bArmed || (getFireTime() > limit)) return false;
+			if (getFireTime() > virtualClock) virtualClock = getFireTime();
+			runPendingInterrupts();
+			return true;
+		}
+
+		void setInterruptLatency(uint32_t latency_counts)
+		{
+			latency = latency_counts;
+		}
+
+		void injectHwTimerInterrupt()
+		{
+			bSoftwarePending = true;
+			runPendingInterrupts();
+		}
+
+		uint32_t getNofInterrupts()
+		{
+			return nofInterrupts;
+		}
+
+		uint32_t getNofDeadlineInterrupts()
+		{
+			return nofDeadlineInterrupts;
+		}
+
+		bool isInIsr()
+		{
+			return bInIsr;
+		}
+
+		uint32_t getNofKernelCalls()
+		{
+			return nofKernelCalls;
+		}
+	}; // end namespace sim
+}; // end namespace crt
+
+using namespace crt::sim;
+
+extern "C" {
+
+uint32_t SystemCoreClock = COUNT_FREQUENCY_HZ;
+DWT_Type crt_sim_dwt = {0, 0};
+
+// The simulated hardware timer.
+
+uint64_t crt_sim_now(void) { return virtualClock; }
+
+void crt_sim_hw_timer_set_callback(CrtSimCallback callback, void* userData)
+{
+	hwCallback = callback;
+	hwUserData = userData;
+	bArmed = false;
+	bSoftwarePending = false;
+}
+
+void crt_sim_hw_timer_fire_at(uint64_t count)
+{
+	deadline = count;
+	bArmed = true;
+	runPendingInterrupts(); // if it has passed already: as soon as possible.
+}
+
+void crt_sim_hw_timer_cancel(void)
+{
+	bArmed = false;
+}
+
+void crt_sim_hw_timer_trigger(void)
+{
+	bSoftwarePending = true;
+	runPendingInterrupts();
+}
+
+// crt_stm_hal.h
+
+uint32_t crt_sim_get_ipsr(void) { return bInIsr ? 1 : 0; }
+uint32_t crt_sim_get_primask(void) { return primask; }
+
+void crt_sim_set_primask(uint32_t newPrimask)
+{
+	primask = newPrimask;
+	runPendingInterrupts();
+}
+
+// FreeRTOS.h
+
+void crt_sim_enter_critical(void)
+{
+	criticalNesting++;
+}
+
+void crt_sim_exit_critical(void)
+{
+	assert(criticalNesting > 0);
+	criticalNesting--;
+	runPendingInterrupts();
+}
+
+UBaseType_t crt_sim_enter_critical_from_isr(void)
+{
+	criticalNesting++;
+	return 0;
+}
+
+void crt_sim_exit_critical_from_isr(UBaseType_t /*saved*/)
+{
+	crt_sim_exit_critical();
+}
+
+size_t xPortGetFreeHeapSize(void) { return 0; }
+
+// task.h
+
+BaseType_t xTaskNotifyGive(TaskHandle_t /*xTaskToNotify*/)
+{
+	nofKernelCalls++;
+	notifyCount++;
+	bNotifyPending = true;
+	return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t /*xTaskToNotify*/, BaseType_t* pxHigherPriorityTaskWoken)
+{
+	nofKernelCalls++;
+	notifyCount++;
+	bNotifyPending = true;
+	if (pxHigherPriorityTaskWoken != NULL) *pxHigherPriorityTaskWoken = pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+	nofKernelCalls++;
+	uint64_t limit = (xTicksToWait == portMAX_DELAY) ? UINT64_MAX : getLimit_ms(xTicksToWait);
+	if (!waitUntil([]{ return notifyCount > 0; }, limit)) return 0;
+	uint32_t count = notifyCount;
+	notifyCount = (xClearCountOnExit != pdFALSE) ? 0 : (notifyCount - 1);
+	bNotifyPending = false;
+	return count;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t /*xTaskToNotify*/, uint32_t ulValue, eNotifyAction eAction)
+{
+	nofKernelCalls++;
+	switch (eAction)
+	{
+	case eSetBits:					notifyCount |= ulValue; break;
+	case eIncrement:				notifyCount++; break;
+	case eSetValueWithOverwrite:	notifyCount = ulValue; break;
+	case eSetValueWithoutOverwrite:
+		if (bNotifyPending) return pdFAIL;
+		notifyCount = ulValue;
+		break;
+	default:						break;
+	}
+	bNotifyPending = true;
+	return pdPASS;
+}
+
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction,
+                              BaseType_t* pxHigherPriorityTaskWoken)
+{
+	if (pxHigherPriorityTaskWoken != NULL) *pxHigherPriorityTaskWoken = pdTRUE;
+	return xTaskNotify(xTaskToNotify, ulValue, eAction);
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit,
+                           uint32_t* pulNotificationValue, TickType_t xTicksToWait)
+{
+	nofKernelCalls++;
+	if (!bNotifyPending) notifyCount &= ~ulBitsToClearOnEntry;
+	uint64_t limit = (xTicksToWait == portMAX_DELAY) ? UINT64_MAX : getLimit_ms(xTicksToWait);
+	bool bReceived = bNotifyPending || ((xTicksToWait != 0) && waitUntil([]{ return bNotifyPending; }, limit));
+	if (pulNotificationValue != NULL) *pulNotificationValue = notifyCount;
+	if (!bReceived) return pdFALSE;
+	notifyCount &= ~ulBitsToClearOnExit;
+	bNotifyPending = false;
+	return pdTRUE;
+}
+
+uint32_t ulTaskNotifyValueClear(TaskHandle_t /*xTask*/, uint32_t ulBitsToClear)
+{
+	nofKernelCalls++;
+	uint32_t previous = notifyCount;
+	notifyCount &= ~ulBitsToClear;
+	return previous;
+}
+
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+	osDelay(xTicksToDelay);
+}
+
+void vTaskSuspendAll(void) {}
+BaseType_t xTaskResumeAll(void) { return pdFALSE; }
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t /*xTask*/) { return 0; }
+
+// stmHwTimer5.h: the virtual clock.
+
+void timer5_init() {}
+uint32_t timer5_get_frequency(void) { return COUNT_FREQUENCY_HZ; }
+void timer5_update_frequency(void) {}
+uint64_t timer5_get_count64(void) { return virtualClock; }
+void timer5_wake_at(uint32_t /*count*/) {}
+void timer5_cancel_wake(void) {}
+
+// cmsis_os2.h
+
+osKernelState_t osKernelGetState(void) { return osKernelRunning; }
+
+uint32_t osKernelGetTickCount(void)
+{
+	return (uint32_t)(virtualClock / (COUNT_FREQUENCY_HZ / configTICK_RATE_HZ));
+}
+
+osThreadId_t osThreadNew(osThreadFunc_t /*func*/, void* argument, const osThreadAttr_t* /*attr*/)
+{
+	return (argument != NULL) ? argument : (void*)&notifyCount; // any non-null handle.
+}
+
+osStatus_t osThreadYield(void) { return osOK; }
+
+osStatus_t osDelay(uint32_t ticks)
+{
+	advanceTo(getLimit_ms(ticks));
+	return osOK;
+}
+
+osEventFlagsId_t osEventFlagsNew(const osEventFlagsAttr_t* /*attr*/)
+{
+	return new uint32_t(0);
+}
+
+uint32_t osEventFlagsSet(osEventFlagsId_t ef_id, uint32_t flags)
+{
+	nofKernelCalls++;
+	uint32_t& eventFlags = *(uint32_t*)ef_id;
+	eventFlags |= flags;
+	return eventFlags;
+}
+
+uint32_t osEventFlagsClear(osEventFlagsId_t ef_id, uint32_t flags)
+{
+	nofKernelCalls++;
+	uint32_t& eventFlags = *(uint32_t*)ef_id;
+	uint32_t previous = eventFlags;
+	eventFlags &= ~flags;
+	return previous;
+}
+
+uint32_t osEventFlagsGet(osEventFlagsId_t ef_id)
+{
+	nofKernelCalls++;
+	return *(uint32_t*)ef_id;
+}
+
+uint32_t osEventFlagsWait(osEventFlagsId_t ef_id, uint32_t flags, uint32_t options, uint32_t timeout)
+{
+	nofKernelCalls++;
+	uint32_t& eventFlags = *(uint32_t*)ef_id;
+	auto bReady = [&]{
+		return ((options & osFlagsWaitAll) != 0) ? ((eventFlags & flags) == flags) : ((eventFlags & flags) != 0);
+	};
+	if (!bReady())
+	{
+		if (timeout == 0) return osFlagsErrorResource;
+		if (!waitUntil(bReady, getLimit_ms(timeout))) return osFlagsErrorTimeout;
+	}
+	uint32_t result = eventFlags;
+	if ((options & osFlagsNoClear) == 0) eventFlags &= ~flags;
+	return result;
+}
+
+osMessageQueueId_t osMessageQueueNew(uint32_t msg_count, uint32_t msg_size, const osMessageQueueAttr_t* /*attr*/)
+{
+	MessageQueue* pQueue = new MessageQueue();
+	pQueue->buffer.resize((size_t)msg_count * msg_size);
+	pQueue->msgSize = msg_size;
+	pQueue->capacity = msg_count;
+	pQueue->head = 0;
+	pQueue->count = 0;
+	return pQueue;
+}
+
+osStatus_t osMessageQueuePut(osMessageQueueId_t mq_id, const void* msg_ptr, uint8_t /*msg_prio*/, uint32_t timeout)
+{
+	nofKernelCalls++;
+	MessageQueue& queue = *(MessageQueue*)mq_id;
+	if (queue.count == queue.capacity)
+	{
+		if (timeout == 0) return osErrorResource;
+		if (!waitUntil([&]{ return queue.count < queue.capacity; }, getLimit_ms(timeout))) return osErrorTimeout;
+	}
+	uint32_t index = (queue.head + queue.count) % queue.capacity;
+	memcpy(&queue.buffer[(size_t)index * queue.msgSize], msg_ptr, queue.msgSize);
+	queue.count++;
+	return osOK;
+}
+
+osStatus_t osMessageQueueGet(osMessageQueueId_t mq_id, void* msg_ptr, uint8_t* msg_prio, uint32_t timeout)
+{
+	nofKernelCalls++;
+	MessageQueue& queue = *(MessageQueue*)mq_id;
+	if (queue.count == 0)
+	{
+		if (timeout == 0) return osErrorResource;
+		if (!waitUntil([&]{ return queue.count > 0; }, getLimit_ms(timeout))) return osErrorTimeout;
+	}
+	memcpy(msg_ptr, &queue.buffer[(size_t)queue.head * queue.msgSize], queue.msgSize);
+	queue.head = (queue.head + 1) % queue.capacity;
+	queue.count--;
+	if (msg_prio != NULL) *msg_prio = 0;
+	return osOK;
+}
+
+uint32_t osMessageQueueGetCount(osMessageQueueId_t mq_id)
+{
+	nofKernelCalls++;
+	return ((MessageQueue*)mq_id)->count;
+}
+
+osMutexId_t osMutexNew(const osMutexAttr_t* /*attr*/)
+{
+	return new uint32_t(0);
+}
+
+osStatus_t osMutexAcquire(osMutexId_t mutex_id, uint32_t /*timeout*/)
+{
+	(*(uint32_t*)mutex_id)++; // a single thread: never blocks (recursive).
+	return osOK;
+}
+
+osStatus_t osMutexRelease(osMutexId_t mutex_id)
+{
+	uint32_t& count = *(uint32_t*)mutex_id;
+	if (count == 0) return osErrorResource;
+	count--;
+	return osOK;
+}
+
+} // end extern "C"
+
+#endif // CRT_SIM
@@ -0,0 +1,76 @@
+#pragma once
+#include <cstdint>
+
+// Host simulation of the hardware under the timing of CleanRTOS, so that Time, Timers_template
+// and Timer compile and run on Linux (or any PC), deterministically.
+//
+// Build with -DCRT_SIM (see crt_Config.h) and with this folder first in the include path:
+// its crt_stm_hal.h, cmsis_os2.h, FreeRTOS.h, .. replace those of the stm project.
+// Compile crt_Sim.cpp along (and crt_LongTimerRelay.cpp, if Timer is used).
+// For example, see src/internals/tests/Sim.
+//
+// What is simulated:
+// - A virtual clock, counting at COUNT_FREQUENCY_HZ. It only advances when asked to (advance_us,
+//   or a wait that would block, see below). It is the time source of Time (as timer5).
+// - A hardware timer with a single deadline, plus a software trigger: HwTimerBackend_Sim,
+//   the backend of Timers (see crt_HwTimerBackend_Sim.h). When the clock reaches its deadline,
+//   its interrupt callback runs (with __get_IPSR() != 0), optionally some latency later.
+// - Critical sections and masked interrupts defer a software triggered interrupt until unmasked.
+//
+// Tasks are not scheduled: osThreadNew does not run the main of a Task. The test (in main)
+// calls the functions of its Task objects itself. A wait that would block (osEventFlagsWait,
+// ulTaskNotifyTake, xTaskNotifyWait, osMessageQueueGet, osDelay) advances the clock from interrupt to interrupt,
+// until it can return. If nothing is armed anymore, it reports a deadlock and aborts.
+namespace crt
+{
+	namespace sim
+	{
+		constexpr uint32_t COUNT_FREQUENCY_HZ = 100000000; // 100MHz: a whole amount of MHz.
+		constexpr uint32_t COUNTS_PER_US = COUNT_FREQUENCY_HZ / 1000000;
+
+		// The virtual clock.
+		uint64_t now();
+		uint64_t now_us();
+
+		// Advances the clock, running the hardware timer interrupt each time its deadline is reached.
+		void advanceTo(uint64_t count);
+		void advance_us(uint64_t duration_us);
+
+		// Advances the clock to the next hardware timer deadline (if it is <= limit), and runs
+		// its interrupt. Returns false if no deadline was armed (before limit).
+		bool runNextInterrupt(uint64_t limit = UINT64_MAX);
+
+		// Injection: the interrupt of a deadline runs latency_counts after it (default 0).
+		void setInterruptLatency(uint32_t latency_counts);
+
+		// Injection: runs the hardware timer interrupt right now, as if it fired (spuriously, or early).
+		// The armed deadline remains armed.
+		void injectHwTimerInterrupt();
+
+		// Statistics.
+		uint32_t getNofInterrupts();			// all runs of the interrupt.
+		uint32_t getNofDeadlineInterrupts();	// the runs for a deadline (not for a software trigger).
+		bool isInIsr();
+
+		// Calls of the kernel objects: event flags, task notifications and message queues
+		// (f.e. to count the syscalls of a waitable, see tests/Sim/crt_BenchQueue.cpp).
+		uint32_t getNofKernelCalls();
+	}; // end namespace sim
+}; // end namespace crt
+
+// C interface of the simulated hardware (used by the shim headers and HwTimerBackend_Sim).
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void (*CrtSimCallback)(void* userData);
+
+uint64_t crt_sim_now(void);
+void crt_sim_hw_timer_set_callback(CrtSimCallback callback, void* userData);
+void crt_sim_hw_timer_fire_at(uint64_t count);
+void crt_sim_hw_timer_cancel(void);
+void crt_sim_hw_timer_trigger(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,31 @@
+// Host simulation (see crt_Sim.h): replaces crt_stm_hal.h of the stm project.
+// Only the parts that Time, Timers_template and Timer use.
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <assert.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern uint32_t SystemCoreClock;
+
+uint32_t crt_sim_get_ipsr(void);		// != 0 while the simulated timer interrupt runs.
+uint32_t crt_sim_get_primask(void);
+void crt_sim_set_primask(uint32_t primask);	// unmasking runs a pending software trigger.
+
+static inline uint32_t __get_IPSR(void) { return crt_sim_get_ipsr(); }
+static inline uint32_t __get_PRIMASK(void) { return crt_sim_get_primask(); }
+static inline void __set_PRIMASK(uint32_t primask) { crt_sim_set_primask(primask); }
+static inline void __disable_irq(void) { crt_sim_set_primask(1); }
+static inline void __enable_irq(void) { crt_sim_set_primask(0); }
+static inline void __DSB(void) {}
+static inline void __ISB(void) {}
+static inline void __WFI(void) {}
+
+#ifdef __cplusplus
+}
+#endif
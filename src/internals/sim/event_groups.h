@@ -0,0 +1,8 @@
+// Host simulation (see crt_Sim.h): replaces event_groups.h of FreeRTOS.
+// (CleanRTOS uses the event flags of cmsis_os2.h)
+
+#pragma once
+#include "FreeRTOS.h"
+
+typedef void* EventGroupHandle_t;
+typedef uint32_t EventBits_t;
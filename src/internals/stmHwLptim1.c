@@ -0,0 +1,194 @@
+#include "crt_Config.h"
+
+#ifdef CRT_TIMER_BACKEND_LPTIM // Anders blijft LPTIM1 (en zijn IRQ handler) vrij voor de applicatie.
+
+#include "stmHwLptim1.h"
+
+#include "crt_stm_hal.h"
+
+#ifndef HAL_LPTIM_MODULE_ENABLED // Alleen op chips met een LPTIM (bijvoorbeeld STM32L4).
+#error "CRT_TIMER_BACKEND_LPTIM vereist een LPTIM (HAL_LPTIM_MODULE_ENABLED), zie crt_Config.h"
+#endif
+
+#include "FreeRTOS.h"
+#include <stddef.h>
+#include <assert.h>
+
+//// LPTIM1 als hardware timer voor Timers, in plaats van timer2.
+//// Hij telt op de LSE (32.768kHz kristal) en blijft doorlopen in Stop modes (Stop2),
+//// zodat timers daar actief blijven, tegen een fractie van het stroomverbruik.
+//// De teller is maar 16 bits: hij loopt vrij (continuous mode) en wrapt elke 2 seconden.
+//// Timers herprogrammeert hem voor langere deadlines (zie LPTIM1_MAX_DELTA_US).
+////
+////
+//// Let op: het IER register (interrupt enables) en ARR mogen alleen geschreven worden
+//// als de LPTIM uit staat. Daarom staan de interrupts altijd aan, en bepaalt
+//// lptim1_armed of een compare match een fire is.
+////
+//// De wraps (ARRM) worden geteld in lptim1_high: samen met de teller een 64 bits tijdbron
+//// die ook in Stop modes doorloopt (zie lptim1_get_count64, zoals timer5_get_count64).
+////
+//// Een schrijf naar CMP wordt pas na een paar LPTIM ticks actief (CMPOK, 60-100 us), en een
+//// volgende schrijf mag pas daarna. Er wordt niet op gewacht: lptim1_fire_after_us schrijft
+//// CMP als er geen schrijf onderweg is, en anders onthoudt hij de nieuwe waarde. De CMPOK
+//// interrupt schrijft die dan alsnog. Zo blijven de kritieke secties van Timers kort.
+
+static LPTIM_HandleTypeDef hlptim1; // static: alleen bekend binnen deze .c file
+
+static TimerCallback lptim1_callback = NULL;
+static void* lptim1_userData = NULL;
+
+static volatile uint32_t lptim1_armed = 0;
+static volatile uint32_t lptim1_software_pending = 0;
+static volatile uint32_t lptim1_high = 0;             // aantal wraps van de 16 bits teller.
+
+static volatile uint16_t lptim1_compare = 0;          // de deadline (de laatst gevraagde CMP waarde).
+static volatile uint32_t lptim1_write_busy = 0;       // een schrijf naar CMP wacht nog op CMPOK.
+static volatile uint32_t lptim1_write_queued = 0;     // lptim1_compare moet nog naar CMP, na CMPOK.
+
+void lptim1_init(void) {
+    if (__HAL_RCC_LPTIM1_IS_CLK_ENABLED()) {
+        assert(0);  // Stop hier als LPTIM1 al bezet is
+    }
+
+    __HAL_RCC_LPTIM1_CONFIG(RCC_LPTIM1CLKSOURCE_LSE);
+    // De LSE moet al aan staan (in de clock config van CubeMX).
+    __HAL_RCC_LPTIM1_CLK_ENABLE();
+
+    hlptim1.Instance = LPTIM1;
+    hlptim1.Init.Clock.Source = LPTIM_CLOCKSOURCE_APBCLOCK_LPOSC;
+    hlptim1.Init.Clock.Prescaler = LPTIM_PRESCALER_DIV1; // 1 tick = 30.5 us.
+    hlptim1.Init.Trigger.Source = LPTIM_TRIGSOURCE_SOFTWARE;
+    hlptim1.Init.OutputPolarity = LPTIM_OUTPUTPOLARITY_HIGH;
+    hlptim1.Init.UpdateMode = LPTIM_UPDATE_IMMEDIATE;
+    hlptim1.Init.CounterSource = LPTIM_COUNTERSOURCE_INTERNAL;
+    HAL_LPTIM_Init(&hlptim1);
+
+    // Zelfde prioriteit als timer2 (zie stmHwTimer2.c): FreeRTOS FromISR functies zijn toegestaan.
+    HAL_NVIC_SetPriority(LPTIM1_IRQn, configLIBRARY_MAX_SYSCALL_INTERRUPT_PRIORITY + 1, 0);
+    HAL_NVIC_EnableIRQ(LPTIM1_IRQn);
+
+    // Wekken uit Stop mode loopt via de EXTI lijn van LPTIM1.
+    __HAL_LPTIM_WAKEUPTIMER_EXTI_ENABLE_IT();
+
+    // Interrupts aan (terwijl de LPTIM nog uit staat), dan de teller starten,
+    // continuous, over het volle 16 bits bereik. Wordt nooit meer gestopt.
+    // (de ARRM interrupt wekt de mcu elke 2 seconden even, om de wraps te tellen)
+    lptim1_high = 0;
+    __HAL_LPTIM_ENABLE_IT(&hlptim1, LPTIM_IT_CMPM | LPTIM_IT_CMPOK | LPTIM_IT_ARRM);
+    HAL_LPTIM_Counter_Start(&hlptim1, 0xFFFF);
+}
+
+void lptim1_set_callback(TimerCallback cb, void* userData) {
+    lptim1_callback = cb;
+    lptim1_userData = userData;
+}
+
+uint32_t lptim1_now(void) {
+    // De teller loopt asynchroon met de cpu klok: lees tot twee keer dezelfde waarde.
+    uint32_t count;
+    do {
+        count = hlptim1.Instance->CNT;
+    } while (count != hlptim1.Instance->CNT);
+    return count;
+}
+
+uint64_t lptim1_get_count64(void) {
+    for (;;) {
+        uint32_t high = lptim1_high;
+        uint32_t low  = lptim1_now();
+        uint32_t bWrapPending = __HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_ARRM);
+
+        if (high != lptim1_high) {
+            continue; // De interrupt kwam er tussendoor: opnieuw.
+        }
+
+        // Wrap gebeurd, maar de interrupt is nog niet afgehandeld (bijvoorbeeld omdat we zelf
+        // in een interrupt of gemaskeerde sectie zitten). Als low klein is, hoort die bij na de wrap.
+        // (ARRM komt bij CNT==0xFFFF, net voor de wrap: dan is low groot)
+        if (bWrapPending && (low < 0x8000u)) {
+            high++;
+        }
+        return (((uint64_t)high) << 16) | low;
+    }
+}
+
+// Precondition: lptim1_write_busy == 0.
+static void lptim1_write_compare(void) {
+    lptim1_write_busy = 1;
+    lptim1_write_queued = 0;
+    __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_CMPOK);
+    __HAL_LPTIM_COMPARE_SET(&hlptim1, lptim1_compare);
+}
+
+void lptim1_fire_after_us(uint32_t delay_us) {
+    if (delay_us > LPTIM1_MAX_DELTA_US) delay_us = LPTIM1_MAX_DELTA_US;
+    // ticks = ceil(us * 32768 / 1000000) = ceil(us * 512 / 15625), exact. Past in 32 bits voor
+    // us <= LPTIM1_MAX_DELTA_US, en een deling door een constante wordt een vermenigvuldiging.
+    // (exact is nodig: Timers rondt zijn delta af naar beneden, en verwacht precies dezelfde ticks terug)
+    uint32_t ticks = (delay_us * 512u + 15624u) / 15625u;
+
+    lptim1_armed = 0;
+    if (ticks == 0) {
+        lptim1_trigger_software_interrupt(); // zo snel mogelijk.
+        return;
+    }
+
+    lptim1_compare = (uint16_t)(lptim1_now() + ticks);
+    lptim1_armed = 1;
+    if (lptim1_write_busy) {
+        lptim1_write_queued = 1; // de CMPOK interrupt schrijft hem.
+    } else {
+        lptim1_write_compare();
+    }
+
+    // Een compare match gebeurt alleen bij CNT==CMP. Als de deadline gepasseerd is voordat
+    // de schrijf actief werd, zou die pas na een wrap (2 seconden) komen. Daarom kijkt de
+    // interrupt bij CMPOK of de deadline al gepasseerd is. (lptim1_armed voorkomt een dubbele fire)
+}
+
+void lptim1_cancel(void) {
+    lptim1_armed = 0;
+}
+
+void lptim1_trigger_software_interrupt(void) {
+    lptim1_software_pending = 1; // gewone store, geen read-modify-write: veilig zonder maskeren.
+    __DSB();
+    NVIC_SetPendingIRQ(LPTIM1_IRQn);
+}
+
+void LPTIM1_IRQHandler(void) {
+    if (__HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_ARRM)) {
+        __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_ARRM);
+        lptim1_high++;
+    }
+    if (__HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_CMPM)) {
+        __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_CMPM);
+        // Elke wrap geeft een match bij dezelfde CMP: alleen als er een deadline staat, is het een fire.
+    }
+    if (__HAL_LPTIM_GET_FLAG(&hlptim1, LPTIM_FLAG_CMPOK)) {
+        __HAL_LPTIM_CLEAR_FLAG(&hlptim1, LPTIM_FLAG_CMPOK);
+        // De schrijf is actief. Een nieuwere deadline die intussen kwam, nu alsnog schrijven.
+        lptim1_write_busy = 0;
+        if (lptim1_write_queued) {
+            lptim1_write_compare();
+        }
+    }
+
+    uint32_t bFire = lptim1_software_pending;
+    lptim1_software_pending = 0;
+
+    if (lptim1_armed) {
+        // Gepasseerd: fire. (ook bij CMPOK, als de deadline al voorbij was voordat CMP actief werd)
+        if ((uint16_t)(lptim1_now() - lptim1_compare) < 0x8000) {
+            lptim1_armed = 0;
+            bFire = 1;
+        }
+    }
+
+    if (bFire && (lptim1_callback != NULL)) {
+        lptim1_callback(lptim1_userData);
+    }
+}
+
+#endif // CRT_TIMER_BACKEND_LPTIM
@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+
+#include "stmHwTimer2.h" // for TimerCallback
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// LPTIM1 (16 bits) as hardware timer for Timers (see crt_HwTimerBackend_Lptim.h).
+// It counts the LSE (32.768kHz crystal) and keeps running in Stop modes (Stop2 on the STM32L4),
+// where timer2 stops. Its interrupt wakes the mcu from those modes.
+// The counter runs freely (continuous mode, wraps every 2 seconds). Its wraps are counted in
+// the interrupt, which extends it to 64 bits: a time base that keeps running in Stop modes.
+// A single deadline is programmed in its compare register.
+// Only available on chips with an LPTIM (HAL_LPTIM_MODULE_ENABLED in the hal conf).
+
+#define LPTIM1_FREQUENCY_HZ 32768u
+
+// Largest delta of lptim1_fire_after_us: half the 16 bit window (a passed deadline must be
+// distinguishable from a future one).
+#define LPTIM1_MAX_DELTA_US 999969u // 0x7FFF ticks.
+
+void lptim1_init(void);
+void lptim1_set_callback(TimerCallback cb, void* userData);
+
+// The callback is called (once) from the LPTIM1 interrupt, delay_us (rounded up to whole
+// ticks of about 30.5 us) from now. 0: as soon as possible.
+// It doesn't wait for the compare register: a write that is still in progress is completed
+// in the interrupt (see stmHwLptim1.c).
+// Call it (and lptim1_cancel) from the LPTIM1 interrupt or with it masked (f.e. in a FreeRTOS
+// critical section), like Timers does.
+void lptim1_fire_after_us(uint32_t delay_us);
+void lptim1_cancel(void);
+
+uint32_t lptim1_now(void);          // the 16 bit counter, in ticks of LPTIM1_FREQUENCY_HZ.
+uint64_t lptim1_get_count64(void);  // the counter, extended with its wraps. Also callable with interrupts masked.
+
+// Software trigger: calls the callback from the LPTIM1 interrupt, like timer2_trigger_software_interrupt.
+void lptim1_trigger_software_interrupt(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -174,7 +174,98 @@ void timer2_resume() {
 //    NVIC_EnableIRQ(TIM2_IRQn);
 //}
 
+// ---------------- Free-running mode ---------------------------------------------
+
+static TimerCallback timer2_compare_callback[TIMER2_NOF_CHANNELS] = { NULL, NULL, NULL, NULL };
+static void* timer2_compare_userData[TIMER2_NOF_CHANNELS] = { NULL, NULL, NULL, NULL };
+
+static const uint32_t timer2_flag_cc[TIMER2_NOF_CHANNELS] = { TIM_FLAG_CC1, TIM_FLAG_CC2, TIM_FLAG_CC3, TIM_FLAG_CC4 };
+static const uint32_t timer2_it_cc[TIMER2_NOF_CHANNELS]   = { TIM_IT_CC1, TIM_IT_CC2, TIM_IT_CC3, TIM_IT_CC4 };
+static const uint32_t timer2_hal_channel[TIMER2_NOF_CHANNELS] = { TIM_CHANNEL_1, TIM_CHANNEL_2, TIM_CHANNEL_3, TIM_CHANNEL_4 };
+
+void timer2_init_free_running() {
+    timer2_init(); // zelfde klok, prescaler (1MHz) en interrupt prioriteit.
+
+    __HAL_TIM_DISABLE_IT(&htim2, TIM_IT_UPDATE);
+    // Geen update-interrupt: de teller loopt door tot 0xFFFFFFFF en wrapt dan naar 0.
+
+    // De kanalen staan na reset in output compare "frozen" mode: bij CNT==CCRx wordt
+    // alleen de CCxIF flag gezet. Precies wat we nodig hebben.
+    __HAL_TIM_CLEAR_FLAG(&htim2, TIM_FLAG_CC1 | TIM_FLAG_CC2 | TIM_FLAG_CC3 | TIM_FLAG_CC4);
+
+    HAL_TIM_Base_Start(&htim2);
+    // Start de teller, eenmalig. Wordt nooit meer gestopt of gereset.
+}
+
+inline uint32_t timer2_now(void) {
+    return __HAL_TIM_GET_COUNTER(&htim2);
+}
+
+inline void timer2_set_compare_callback(Timer2Channel channel, TimerCallback cb, void* userData) {
+    assert(channel < TIMER2_NOF_CHANNELS);
+    timer2_compare_callback[channel] = cb;
+    timer2_compare_userData[channel] = userData;
+}
+
+inline void timer2_fire_at_us(Timer2Channel channel, uint32_t compare_us) {
+    __HAL_TIM_SET_COMPARE(&htim2, timer2_hal_channel[channel], compare_us);
+    __HAL_TIM_CLEAR_FLAG(&htim2, timer2_flag_cc[channel]);
+    __HAL_TIM_ENABLE_IT(&htim2, timer2_it_cc[channel]);
+
+    // Een compare match gebeurt alleen bij CNT==CCRx. Als de deadline al gepasseerd is
+    // (of net tijdens het schrijven), zou die pas na een wrap (71 minuten) komen.
+    // Forceer dan het compare event via de event generation register.
+    // (als de match toch net plaatsvond, levert dat geen dubbele interrupt op: het is dezelfde flag)
+    if ((int32_t)(compare_us - timer2_now()) <= 0) {
+        htim2.Instance->EGR = (TIM_EGR_CC1G << channel);
+    }
+}
+
+inline void timer2_cancel(Timer2Channel channel) {
+    __HAL_TIM_DISABLE_IT(&htim2, timer2_it_cc[channel]);
+    __HAL_TIM_CLEAR_FLAG(&htim2, timer2_flag_cc[channel]);
+}
+
+// ---------------- Software trigger ----------------------------------------------
+
+static TimerCallback timer2_software_callback = NULL;
+static void* timer2_software_userData = NULL;
+static volatile uint32_t timer2_software_pending = 0;
+
+inline void timer2_set_software_callback(TimerCallback cb, void* userData) {
+    timer2_software_callback = cb;
+    timer2_software_userData = userData;
+}
+
+void timer2_trigger_software_interrupt(void) {
+    timer2_software_pending = 1; // gewone store, geen read-modify-write: veilig zonder maskeren.
+    __DSB();
+    NVIC_SetPendingIRQ(TIM2_IRQn);
+}
+
 void TIM2_IRQHandler(void) {
+    // Software trigger: eerst de vlag wissen, zodat een trigger tijdens de callback
+    // opnieuw een interrupt oplevert.
+    if (timer2_software_pending) {
+        timer2_software_pending = 0;
+        if (timer2_software_callback != NULL) {
+            timer2_software_callback(timer2_software_userData);
+        }
+    }
+
+    // Free-running mode: compare channels. One-shot: de interrupt van het kanaal wordt
+    // uitgezet, de callback zet eventueel een nieuwe deadline.
+    for (uint32_t channel = 0; channel < TIMER2_NOF_CHANNELS; channel++) {
+        if (__HAL_TIM_GET_FLAG(&htim2, timer2_flag_cc[channel]) &&
+            __HAL_TIM_GET_IT_SOURCE(&htim2, timer2_it_cc[channel])) {
+            __HAL_TIM_DISABLE_IT(&htim2, timer2_it_cc[channel]);
+            __HAL_TIM_CLEAR_IT(&htim2, timer2_flag_cc[channel]);
+            if (timer2_compare_callback[channel] != NULL) {
+                timer2_compare_callback[channel](timer2_compare_userData[channel]);
+            }
+        }
+    }
+
     if (__HAL_TIM_GET_FLAG(&htim2, TIM_FLAG_UPDATE) &&
         __HAL_TIM_GET_IT_SOURCE(&htim2, TIM_IT_UPDATE)) {
         // Controleer of TIM2 daadwerkelijk een update interrupt heeft gegenereerd
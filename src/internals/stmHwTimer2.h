@@ -19,6 +19,31 @@ void timer2_resume();
 void timer2_set_callback(TimerCallback cb, void* userData);
 uint8_t timer2_is_running(void);
 
+// Free-running mode (alternative for the one-shot mode above):
+// The 32 bit counter runs continuously at 1MHz and is never reset, so it can be used as
+// a microsecond clock (it wraps after about 71 minutes).
+// Deadlines are programmed in the compare registers CCR1..CCR4: four independent
+// one-shot deadlines, each with its own callback. No pause/resume is needed to
+// reprogram a deadline; the counter keeps running.
+#define TIMER2_NOF_CHANNELS 4
+typedef enum { TIMER2_CHANNEL_1 = 0, TIMER2_CHANNEL_2, TIMER2_CHANNEL_3, TIMER2_CHANNEL_4 } Timer2Channel;
+
+void timer2_init_free_running();
+uint32_t timer2_now(void);  // current counter value in us.
+void timer2_set_compare_callback(Timer2Channel channel, TimerCallback cb, void* userData);
+
+// The callback of channel is called (once) from the timer2 interrupt when the counter reaches
+// compare_us. If compare_us has passed already, it is called as soon as possible.
+// Precondition: compare_us - timer2_now() < 2^31 (otherwise it counts as passed already).
+void timer2_fire_at_us(Timer2Channel channel, uint32_t compare_us);
+void timer2_cancel(Timer2Channel channel);
+
+// Software trigger: runs the software callback from the timer2 interrupt (at its priority),
+// by pending that interrupt in the NVIC. Callable from tasks and ISRs, without masking interrupts.
+// Triggers that are done before the interrupt runs, result in a single callback.
+void timer2_set_software_callback(TimerCallback cb, void* userData);
+void timer2_trigger_software_interrupt(void);
+
 #ifdef __cplusplus
 }
 #endif
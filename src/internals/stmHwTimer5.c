@@ -0,0 +1,128 @@
+#include "crt_Config.h"
+
+#ifdef CRT_TIME_SOURCE_TIM5 // Anders blijft TIM5 vrij, bijvoorbeeld als timebase van de HAL.
+
+#include "stmHwTimer5.h"
+
+#include "crt_stm_hal.h"
+#include "FreeRTOS.h"
+#include <assert.h>
+
+//// Timer5 als 64 bits tijdbron.
+//// De 32 bits teller loopt op de volle timerklok van APB1 (bijvoorbeeld 84MHz) en loopt
+//// dus na ongeveer 51 seconden over. Bij elke overloop verhoogt de interrupt hieronder
+//// de bovenste 32 bits. Dat vervangt de Time task, die anders periodiek de DWT cyclecounter
+//// moest uitlezen voordat die overliep.
+
+static TIM_HandleTypeDef htim5; // static: alleen bekend binnen deze .c file
+
+static volatile uint32_t timer5_high = 0;  // bovenste 32 bits van de 64 bits count.
+static uint32_t timer5_frequency = 0;
+
+// Timer2 en Timer5 (beide 32 bits timers) zitten op de APB1 bus.
+static uint32_t getTimerClock_APB1()
+{
+	uint32_t timer_clock = HAL_RCC_GetPCLK1Freq();
+
+	RCC_ClkInitTypeDef clkconfig;
+	uint32_t flashLatency;
+
+	HAL_RCC_GetClockConfig(&clkconfig, &flashLatency);
+
+	if (clkconfig.APB1CLKDivider != RCC_HCLK_DIV1) {
+		timer_clock *= 2;
+	}
+	return timer_clock;
+}
+
+void timer5_update_frequency(void) {
+	timer5_frequency = getTimerClock_APB1();
+}
+
+uint32_t timer5_get_frequency(void) {
+	return timer5_frequency;
+}
+
+void timer5_init() {
+    if (__HAL_RCC_TIM5_IS_CLK_ENABLED()) {
+        // TIM5-klok is al aan — dus mogelijk elders in gebruik
+        assert(0);  // Stop hier als TIM5 al bezet is
+    }
+
+    __HAL_RCC_TIM5_CLK_ENABLE();
+
+    htim5.Instance = TIM5;
+    htim5.Init.Prescaler = 0;
+    // Geen prescaler: elke tick van de timerklok telt. (maximale resolutie)
+
+    htim5.Init.CounterMode = TIM_COUNTERMODE_UP;
+    htim5.Init.Period = 0xFFFFFFFF;
+    // Volledig 32 bits bereik: de update (overloop) komt precies bij de wrap naar 0.
+
+    htim5.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+
+    HAL_TIM_Base_Init(&htim5);
+
+    timer5_update_frequency();
+
+    timer5_high = 0;
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_UPDATE);
+
+    HAL_NVIC_SetPriority(TIM5_IRQn, 0, 0);
+    // Hoogste prioriteit: de interrupt is kort en roept geen FreeRTOS functies aan.
+    // (en wordt dus ook niet gemaskeerd door kritieke secties van FreeRTOS.
+    //  Als hij toch gemaskeerd is, vangt timer5_get_count64 dat op.)
+
+    HAL_NVIC_EnableIRQ(TIM5_IRQn);
+
+    HAL_TIM_Base_Start(&htim5);
+    // Start de teller, eenmalig. Wordt nooit meer gestopt of gereset.
+}
+
+uint64_t timer5_get_count64(void) {
+    for (;;) {
+        uint32_t high = timer5_high;
+        uint32_t low  = __HAL_TIM_GET_COUNTER(&htim5);
+        uint32_t bOverflowPending = __HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_UPDATE);
+
+        if (high != timer5_high) {
+            continue; // De interrupt kwam er tussendoor: opnieuw.
+        }
+
+        // Overloop gebeurd, maar de interrupt is nog niet afgehandeld (bijvoorbeeld omdat we zelf
+        // in een interrupt of gemaskeerde sectie zitten). Als low klein is, hoort die bij na de wrap.
+        // (als low groot is, is low nog voor de wrap gelezen)
+        if (bOverflowPending && (low < 0x80000000u)) {
+            high++;
+        }
+        return (((uint64_t)high) << 32) | low;
+    }
+}
+
+void timer5_wake_at(uint32_t count) {
+    __HAL_TIM_SET_COMPARE(&htim5, TIM_CHANNEL_1, count);
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC1);
+    __HAL_TIM_ENABLE_IT(&htim5, TIM_IT_CC1);
+}
+
+void timer5_cancel_wake(void) {
+    __HAL_TIM_DISABLE_IT(&htim5, TIM_IT_CC1);
+    __HAL_TIM_CLEAR_FLAG(&htim5, TIM_FLAG_CC1);
+}
+
+void TIM5_IRQHandler(void) {
+    if (__HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_UPDATE) &&
+        __HAL_TIM_GET_IT_SOURCE(&htim5, TIM_IT_UPDATE)) {
+        __HAL_TIM_CLEAR_IT(&htim5, TIM_IT_UPDATE);
+        timer5_high++;
+    }
+    if (__HAL_TIM_GET_FLAG(&htim5, TIM_FLAG_CC1) &&
+        __HAL_TIM_GET_IT_SOURCE(&htim5, TIM_IT_CC1)) {
+        // Wake-up van tickless idle: alleen de __WFI hoeft te eindigen. Eenmalig.
+        __HAL_TIM_DISABLE_IT(&htim5, TIM_IT_CC1);
+        __HAL_TIM_CLEAR_IT(&htim5, TIM_IT_CC1);
+    }
+}
+
+#endif // CRT_TIME_SOURCE_TIM5
@@ -0,0 +1,31 @@
+#pragma once
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Timer5 (32 bits) as 64 bit time source: it counts at the timer clock of APB1 (no prescaler),
+// and its overflow interrupt extends the count to 64 bits. No task is needed to keep track
+// of overflows, and no counts are lost.
+// Used by crt::Time if CRT_TIME_SOURCE_TIM5 is defined (see crt_Config.h).
+
+void timer5_init();
+
+// Counts per second. Call timer5_update_frequency after reconfiguring the clocks.
+uint32_t timer5_get_frequency(void);
+void timer5_update_frequency(void);
+
+// 64 bit count. Safe to call from tasks and ISRs, also with interrupts masked
+// (an overflow that is pending, but not yet handled, is accounted for).
+uint64_t timer5_get_count64(void);
+
+// Wake-up for tickless idle (see crt_TicklessIdle.cpp): compare channel 1 interrupts once,
+// when the low 32 bits of the count reach count. Its only purpose is to end a __WFI.
+// count must lie less than 2^31 counts ahead.
+void timer5_wake_at(uint32_t count);
+void timer5_cancel_wake(void);
+
+#ifdef __cplusplus
+}
+#endif
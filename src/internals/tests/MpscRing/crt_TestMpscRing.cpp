@@ -0,0 +1,116 @@
+// Host-side stress test of crt::MpscRing (the command ring of Timers, see CRT_TIMERS_COMMAND_QUEUE).
+//
+// It runs on a PC (not on the stm): MpscRing has no hardware dependencies.
+// Build and run, from this folder:
+//   g++ -O2 -std=c++17 -pthread -DCRT_SIM -I../.. crt_TestMpscRing.cpp -o testMpscRing && ./testMpscRing
+//
+// Several producer threads push numbered items into a small ring, while a single consumer
+// thread pops them. It checks that:
+//   - every item arrives exactly once, and the items of each producer arrive in order,
+//   - isPopped(ticket) becomes true for every ticket, once its item has been popped.
+// It returns 1 at the first violation.
+// The whole file is guarded with CRT_SIM: the stm project compiles all sources under src/internals.
+
+#ifdef CRT_SIM
+
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "crt_MpscRing.h"
+
+using namespace crt;
+
+namespace crt_testmpscring
+{
+	constexpr uint32_t NOF_PRODUCERS = 4;
+	constexpr uint32_t NOF_ITEMS_PER_PRODUCER = 1'000'000;
+
+	struct Item
+	{
+		uint32_t producer;
+		uint32_t number;
+	};
+
+	static MpscRing<Item, 16> ring;
+	static std::atomic<bool> bFailed(false);
+
+	static void producer(uint32_t iProducer)
+	{
+		for (uint32_t number = 0; number < NOF_ITEMS_PER_PRODUCER; number++)
+		{
+			uint32_t ticket = 0;
+			while (!ring.tryPush(Item{iProducer, number}, ticket))
+			{
+				std::this_thread::yield(); // full.
+			}
+			if ((number % 1000) == 0)
+			{
+				// Like Timers::stopTimer: wait until the consumer has handled it.
+				while (!ring.isPopped(ticket))
+				{
+					if (bFailed) return;
+					std::this_thread::yield();
+				}
+			}
+		}
+	}
+
+	static void consumer()
+	{
+		std::vector<uint32_t> arNextNumber(NOF_PRODUCERS, 0);
+		uint64_t nofItems = 0;
+		while (nofItems < (uint64_t)NOF_PRODUCERS * NOF_ITEMS_PER_PRODUCER)
+		{
+			Item item;
+			if (!ring.tryPop(item))
+			{
+				std::this_thread::yield(); // empty.
+				continue;
+			}
+
+			if ((item.producer >= NOF_PRODUCERS) || (item.number != arNextNumber[item.producer]))
+			{
+				printf("MISMATCH: producer %" PRIu32 " item %" PRIu32 ", expected item %" PRIu32 "\n",
+				       item.producer, item.number,
+				       (item.producer < NOF_PRODUCERS) ? arNextNumber[item.producer] : 0);
+				bFailed = true;
+				return;
+			}
+			arNextNumber[item.producer]++;
+			nofItems++;
+		}
+	}
+
+	static int run()
+	{
+		std::thread consumerThread(consumer);
+		std::vector<std::thread> producerThreads;
+		for (uint32_t i = 0; i < NOF_PRODUCERS; i++)
+		{
+			producerThreads.emplace_back(producer, i);
+		}
+		for (std::thread& t : producerThreads) t.join();
+		consumerThread.join();
+
+		if (bFailed) return 1;
+		if (!ring.isEmpty())
+		{
+			printf("FAIL: ring not empty at the end.\n");
+			return 1;
+		}
+		printf("MpscRing: %" PRIu32 " producers x %" PRIu32 " items: all arrived once, in order.\n",
+		       NOF_PRODUCERS, NOF_ITEMS_PER_PRODUCER);
+		return 0;
+	}
+};// end namespace crt_testmpscring
+
+int main()
+{
+	return crt_testmpscring::run();
+}
+
+#endif // CRT_SIM
@@ -0,0 +1,130 @@
+// Host-side exactness test of crt::Reciprocal64 (used by crt::Time for its conversions).
+//
+// It runs on a PC (not on the stm): Reciprocal64 has no hardware dependencies.
+// Build and run, from this folder:
+//   g++ -O2 -std=c++17 -DCRT_SIM -I../.. crt_TestReciprocal64.cpp -o testReciprocal64 && ./testReciprocal64
+//
+// For a range of divisors (typical core clocks, powers of 2, worst cases for the magic),
+// divide(n) and mulDiv(n, a) are compared with the exact result computed with __int128:
+//   - at the edges of the 64 bit range, and around multiples of the divisor,
+//   - for random n of every bit length 0..64.
+// It prints the number of checks, and returns 1 at the first mismatch.
+// The whole file is guarded with CRT_SIM: the stm project compiles all sources under src/internals.
+
+#ifdef CRT_SIM
+
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <random>
+#include <vector>
+
+#include "crt_Reciprocal64.h"
+
+using namespace crt;
+
+namespace crt_testreciprocal64
+{
+	typedef unsigned __int128 u128;
+
+	static uint64_t nofChecks = 0;
+
+	static bool check(const Reciprocal64& r, uint64_t n)
+	{
+		uint64_t d = r.getDivisor();
+		nofChecks++;
+		if (r.divide(n) != n / d)
+		{
+			printf("MISMATCH divide: n=%" PRIu64 " d=%" PRIu64 " got %" PRIu64 " expected %" PRIu64 "\n",
+			       n, d, r.divide(n), n / d);
+			return false;
+		}
+
+		// mulDiv precondition: (d-1)*a fits in 64 bits.
+		for (uint64_t a : { 1ull, 1000ull, 1000000ull, 1000000000ull })
+		{
+			if ((u128)(d - 1) * a > (u128)UINT64_MAX) continue;
+			u128 expected = ((u128)n * a) / d;
+			if (expected > (u128)UINT64_MAX) continue; // does not fit in the result.
+			nofChecks++;
+			if (r.mulDiv(n, a) != (uint64_t)expected)
+			{
+				printf("MISMATCH mulDiv: n=%" PRIu64 " a=%" PRIu64 " d=%" PRIu64 " got %" PRIu64 " expected %" PRIu64 "\n",
+				       n, a, d, r.mulDiv(n, a), (uint64_t)expected);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static bool testDivisor(uint64_t d, std::mt19937_64& rng)
+	{
+		Reciprocal64 r(d);
+
+		// Edges.
+		const uint64_t edges[] = { 0, 1, 2, d - 1, d, d + 1, 2 * d - 1, 2 * d,
+		                           UINT64_MAX, UINT64_MAX - 1, UINT64_MAX / 2, UINT64_MAX / 2 + 1,
+		                           (UINT64_MAX / d) * d, (UINT64_MAX / d) * d - 1 };
+		for (uint64_t n : edges)
+		{
+			if (!check(r, n)) return false;
+		}
+
+		// Around random multiples of d: that is where rounding errors of the magic show up.
+		for (int i = 0; i < 2000; i++)
+		{
+			uint64_t q = rng() % (UINT64_MAX / d);
+			uint64_t n = q * d;
+			if (!check(r, n) || !check(r, n - 1) || !check(r, n + d - 1)) return false;
+		}
+
+		// Random n of every bit length.
+		for (int bits = 0; bits <= 64; bits++)
+		{
+			for (int i = 0; i < 2000; i++)
+			{
+				uint64_t n = rng();
+				n = (bits == 64) ? n : (n & ((((uint64_t)1) << bits) - 1));
+				if (!check(r, n)) return false;
+			}
+		}
+		return true;
+	}
+
+	static int run()
+	{
+		std::mt19937_64 rng(12345);
+
+		std::vector<uint64_t> divisors = {
+			// core clocks
+			16'000'000, 24'000'000, 32'000'000, 48'000'000, 64'000'000, 72'000'000, 80'000'000,
+			84'000'000, 96'000'000, 100'000'000, 120'000'000, 168'000'000, 180'000'000,
+			216'000'000, 480'000'000, 32'768, 4'194'304, 8'000'000,
+			// small, odd, powers of 2 and their neighbours
+			1, 2, 3, 5, 6, 7, 10, 641, 1000, 1'000'000, 999'999'937,
+			(1ull << 31) - 1, 1ull << 31, (1ull << 31) + 1, (1ull << 32) - 1,
+			1ull << 32, (1ull << 32) + 1, 1ull << 63, (1ull << 63) + 1, UINT64_MAX,
+		};
+		for (int i = 0; i < 200; i++)
+		{
+			divisors.push_back((rng() >> (rng() % 64)) | 1);
+			divisors.push_back((rng() % 500'000'000) + 1);
+		}
+
+		for (uint64_t d : divisors)
+		{
+			if (d == 0) continue;
+			if (!testDivisor(d, rng)) return 1;
+		}
+
+		printf("Reciprocal64: %" PRIu64 " checks over %zu divisors: all exact.\n", nofChecks, divisors.size());
+		return 0;
+	}
+};// end namespace crt_testreciprocal64
+
+int main()
+{
+	return crt_testreciprocal64::run();
+}
+
+#endif // CRT_SIM
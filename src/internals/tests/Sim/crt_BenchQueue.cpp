@@ -0,0 +1,144 @@
+// Host-side benchmark of the kernel calls ("syscalls") per message of a Queue waitable,
+// on the simulated hardware (see sim/crt_Sim.h).
+//
+// It runs on a PC (not on the stm). Build and run, from this folder:
+//   g++ -O2 -std=c++17 -DCRT_SIM -I../../sim -I../.. -I../../.. crt_BenchQueue.cpp ../../sim/crt_Sim.cpp
+//       -o benchQueue && ./benchQueue
+// (add -DCRT_TASK_NOTIFICATION_EVENTS and/or -DCRT_MAX_NOF_WAITABLES=100 for the other variants of Task)
+//
+// A task owns a Queue and a Flag. Per scenario, it reports the kernel calls per message
+// (sim::getNofKernelCalls: event flags, task notifications and message queues), in total and
+// apart from the osMessageQueuePut and osMessageQueueGet that every message needs:
+//   single  : write 1 message, wait for the queue, read it.
+//   burst   : write 8 messages, then 8 times: waitAny(queue + flag), hasFired(queue), read.
+//   waitAll : set the flag, write 1 message, waitAll(queue + flag), read.
+//
+// Bookkeeping calls per message, measured (the simulation implies CRT_TIMER_DIRECT_ISR_DELIVERY,
+// so a set from a task is an osEventFlagsSet plus a task notification):
+//                          single      burst       waitAll
+//                       before after before after before after
+//   default               6     2    6.88  1.25    8     5
+//   notification events   6     1    5     1.12    7     4
+//   two-level mask        3     2    4.75  0.25    5     4
+//   both                  2     1    2.88  0.12    3     2
+// Before, every write set the event bit, every read called osMessageQueueGetCount and then set
+// or cleared the bit, and waitAll cleared the queue bits and set them again.
+// After, the Queue counts its messages and tells its task when it becomes (non)empty, in user
+// space. The event bit only wakes the task, when the queue becomes non-empty.
+// (waitAll includes the set of the flag)
+// The whole file is guarded with CRT_SIM: the stm project compiles all sources under src/internals.
+
+#ifdef CRT_SIM
+
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+
+#include "crt_Sim.h"
+#include "crt_CleanRTOS.h"
+
+using namespace crt;
+
+namespace crt_benchqueue
+{
+	constexpr uint32_t NOF_MESSAGES = 800; // a multiple of BURST_SIZE.
+	constexpr uint32_t BURST_SIZE = 8;
+
+	static void report(const char* scenario, uint32_t nofCalls)
+	{
+		printf("  %-8s: %6.2f calls/message, of which %5.2f bookkeeping\n", scenario,
+		       (double)nofCalls / NOF_MESSAGES, (double)nofCalls / NOF_MESSAGES - 2.0);
+	}
+
+	// The scenarios are run by main, via the functions of this task (tasks are not scheduled in the simulation).
+	class BenchTask : public Task
+	{
+	public:
+		Queue<uint32_t, 16> queue;
+		Flag flag;
+		uint32_t checksum;
+
+		BenchTask() : Task("BenchTask", osPriorityNormal, 1024), queue(this), flag(this), checksum(0)
+		{
+			start();
+		}
+
+		void main() override {}
+
+		uint32_t benchSingle()
+		{
+			uint32_t nofCallsAtStart = sim::getNofKernelCalls();
+			for (uint32_t i = 0; i < NOF_MESSAGES; i++)
+			{
+				queue.write(i);
+				wait(queue);
+				uint32_t message;
+				queue.read(message);
+				checksum += message;
+			}
+			return sim::getNofKernelCalls() - nofCallsAtStart;
+		}
+
+		uint32_t benchBurst()
+		{
+			uint32_t nofCallsAtStart = sim::getNofKernelCalls();
+			for (uint32_t i = 0; i < NOF_MESSAGES; i += BURST_SIZE)
+			{
+				for (uint32_t j = 0; j < BURST_SIZE; j++) queue.write(i + j);
+				for (uint32_t j = 0; j < BURST_SIZE; j++)
+				{
+					waitAny(queue + flag);
+					if (hasFired(queue))
+					{
+						uint32_t message;
+						queue.read(message);
+						checksum += message;
+					}
+				}
+			}
+			return sim::getNofKernelCalls() - nofCallsAtStart;
+		}
+
+		uint32_t benchWaitAll()
+		{
+			uint32_t nofCallsAtStart = sim::getNofKernelCalls();
+			for (uint32_t i = 0; i < NOF_MESSAGES; i++)
+			{
+				flag.set();
+				queue.write(i);
+				waitAll(queue + flag);
+				uint32_t message;
+				queue.read(message);
+				checksum += message;
+			}
+			return sim::getNofKernelCalls() - nofCallsAtStart;
+		}
+	};
+
+	static int run()
+	{
+		static Time time; // timer5: the virtual clock.
+		static BenchTask benchTask;
+
+		printf("Queue: kernel calls per message (%" PRIu32 " messages per scenario)\n", NOF_MESSAGES);
+		report("single", benchTask.benchSingle());
+		report("burst", benchTask.benchBurst());
+		report("waitAll", benchTask.benchWaitAll());
+
+		uint32_t expected = 3 * (NOF_MESSAGES * (NOF_MESSAGES - 1) / 2);
+		if (benchTask.checksum != expected || !benchTask.queue.isEmpty() || benchTask.isSet(benchTask.queue))
+		{
+			printf("FAIL: messages lost or queue not empty (checksum %" PRIu32 ", expected %" PRIu32 ")\n",
+			       benchTask.checksum, expected);
+			return 1;
+		}
+		return 0;
+	}
+}; // end namespace crt_benchqueue
+
+int main()
+{
+	return crt_benchqueue::run();
+}
+
+#endif // CRT_SIM
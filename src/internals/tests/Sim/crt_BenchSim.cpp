@@ -0,0 +1,166 @@
+// Host-side benchmark of Timers_template as a whole (engine, slack, rearming), with thousands of
+// timers, on the simulated hardware (see sim/crt_Sim.h).
+//
+// It runs on a PC (not on the stm). Build and run, from this folder:
+//   g++ -O2 -std=c++17 -DCRT_SIM -I../../sim -I../.. -I../../.. crt_BenchSim.cpp ../../sim/crt_Sim.cpp
+//       -o benchSim && ./benchSim
+//
+// Unlike src/internals/tests/TimerQueues (the queue engines alone), this runs the complete Timers:
+// NOF_TIMERS periodic timers (1ms .. 1s) run for SIMULATED_TIME_US of virtual time, while the
+// "task" restarts a random timer after every interrupt. Per engine, and without and with slack
+// (10% of the period), it reports:
+//   fires, interrupts : the amount of timer fires and of hardware timer interrupts (virtual, exact)
+//   ns/fire           : host time per fire, of the interrupt handling plus the restarts.
+//                       (the ratio between the engines is what matters, not the absolute value)
+// It verifies that all engines fire the same timers at the same (virtual) times (without slack).
+// It returns 1 if they don't.
+// The whole file is guarded with CRT_SIM: the stm project compiles all sources under src/internals.
+
+#ifdef CRT_SIM
+
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <chrono>
+#include <random>
+
+#include "crt_Sim.h"
+#include "crt_CleanRTOS.h"
+
+using namespace crt;
+
+namespace crt_benchsim
+{
+	constexpr int32_t NOF_TIMERS = 4000;
+	constexpr uint64_t SIMULATED_TIME_US = 500000;
+
+	struct Result
+	{
+		uint64_t nofFires = 0;
+		uint32_t nofInterrupts = 0;
+		uint64_t checksum = 0;	// independent of the order of fires within one interrupt.
+		double   ns_per_fire = 0;
+	};
+
+	static uint64_t start_us = 0;
+	static Result* pResult = nullptr;
+
+	static void onFire(void* userArg)
+	{
+		uint64_t iTimer = (uint64_t)(uintptr_t)userArg;
+		pResult->nofFires++;
+		pResult->checksum += (iTimer + 1) * (sim::now_us() - start_us + 1);
+	}
+
+	static inline uint64_t now_ns()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Periods as used by typical CleanRTOS applications: 1ms .. 1s.
+	// (thousands of timers of 100us would leave no time for the cpu: they don't occur)
+	static uint32_t randomPeriod(std::mt19937& rng)
+	{
+		static const uint32_t periods[] = { 1'000, 2'000, 10'000, 50'000, 100'000, 1'000'000 };
+		uint32_t base = periods[rng() % (sizeof(periods)/sizeof(periods[0]))];
+		return base + (rng() % (base/4 + 1));
+	}
+
+	template <template <typename, int32_t> class TIMER_QUEUE>
+	static Result bench(bool bSlack)
+	{
+		using BenchTimers = Timers_template<NOF_TIMERS, TIMER_QUEUE, HwTimerBackend_Sim>;
+		static TimerHandle arHandle[NOF_TIMERS]; // (per engine)
+		static bool bCreated = false;
+
+		BenchTimers::setOverheads(0, 0, true);
+		// Every engine has its own Timers, but there is one simulated hardware timer: take it over.
+		HwTimerBackend_Sim::init(BenchTimers::timerCallback, &BenchTimers::instance());
+		if (!bCreated)
+		{
+			for (int32_t i = 0; i < NOF_TIMERS; i++)
+			{
+				arHandle[i] = BenchTimers::createTimer("bench", onFire, (void*)(uintptr_t)i);
+			}
+			bCreated = true;
+		}
+
+		Result result;
+		pResult = &result;
+		std::mt19937 rng(12345);
+		uint32_t nofInterrupts = sim::getNofInterrupts();
+		start_us = sim::now_us();
+		uint64_t startHost_ns = now_ns();
+
+		for (int32_t i = 0; i < NOF_TIMERS; i++)
+		{
+			uint32_t period_us = randomPeriod(rng);
+			BenchTimers::startTimer(arHandle[i], period_us, true, PeriodMode::FixedRate, OverrunPolicy::CatchUp,
+			                        bSlack ? period_us / 10 : 0);
+		}
+
+		uint64_t end = sim::now() + SIMULATED_TIME_US * sim::COUNTS_PER_US;
+		while (sim::runNextInterrupt(end))
+		{
+			uint32_t period_us = randomPeriod(rng);
+			BenchTimers::startTimer(arHandle[rng() % NOF_TIMERS], period_us, true, PeriodMode::FixedRate,
+			                        OverrunPolicy::CatchUp, bSlack ? period_us / 10 : 0);
+		}
+
+		result.ns_per_fire = (double)(now_ns() - startHost_ns) / (result.nofFires ? result.nofFires : 1);
+		result.nofInterrupts = sim::getNofInterrupts() - nofInterrupts;
+
+		for (int32_t i = 0; i < NOF_TIMERS; i++)
+		{
+			BenchTimers::stopTimer(arHandle[i]);
+		}
+		sim::advanceTo(end);
+		return result;
+	}
+
+	static void print(const char* name, const Result& result)
+	{
+		printf("  %-12s fires %8" PRIu64 "  interrupts %8" PRIu32 "  %8.1f ns/fire\n",
+		       name, result.nofFires, result.nofInterrupts, result.ns_per_fire);
+	}
+
+	static int run()
+	{
+		static Time time; // timer5: the virtual clock.
+		bool bFailed = false;
+
+		for (bool bSlack : { false, true })
+		{
+			printf("%" PRId32 " periodic timers, %" PRIu64 " ms virtual time, %s:\n",
+			       NOF_TIMERS, SIMULATED_TIME_US / 1000, bSlack ? "slack 10%" : "no slack");
+			Result sortedList  = bench<TimerQueue_SortedList>(bSlack);
+			Result timingWheel = bench<TimerQueue_TimingWheel>(bSlack);
+			Result binaryHeap  = bench<TimerQueue_BinaryHeap>(bSlack);
+			print("SortedList", sortedList);
+			print("TimingWheel", timingWheel);
+			print("BinaryHeap", binaryHeap);
+
+			// With slack, which timers fire along early depends on the order of timers with the same
+			// deadline, and that differs per engine (all fire within their window). So compare without only.
+			if (bSlack) continue;
+			for (const Result* pOther : { &timingWheel, &binaryHeap })
+			{
+				if ((pOther->nofFires != sortedList.nofFires) || (pOther->checksum != sortedList.checksum) ||
+				    (pOther->nofInterrupts != sortedList.nofInterrupts))
+				{
+					printf("FAIL: the engines fire differently.\n");
+					bFailed = true;
+				}
+			}
+		}
+		return bFailed ? 1 : 0;
+	}
+}; // end namespace crt_benchsim
+
+int main()
+{
+	return crt_benchsim::run();
+}
+
+#endif // CRT_SIM
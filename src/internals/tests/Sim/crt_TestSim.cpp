@@ -0,0 +1,504 @@
+// Host-side unit tests of Timers, Timer and Time, on the simulated hardware (see sim/crt_Sim.h).
+//
+// It runs on a PC (not on the stm), deterministically: all times are exact virtual times.
+// Build and run, from this folder:
+//   g++ -O2 -std=c++17 -DCRT_SIM -I../../sim -I../.. -I../../.. crt_TestSim.cpp ../../sim/crt_Sim.cpp
+//       ../../crt_LongTimerRelay.cpp -o testSim && ./testSim
+// (the sim folder must come first: its crt_stm_hal.h, cmsis_os2.h, .. replace those of the stm project)
+//
+// It checks that:
+//   - Timer::sleep_us returns exactly after the requested time (with the overheads set to 0),
+//   - a FixedRate periodic timer stays on its grid, also with interrupt latency,
+//   - a FixedRate periodic timer with OverrunPolicy::Skip skips missed periods,
+//   - a timer beyond the range of the hardware timer fires exactly, after rearms,
+//   - a stopped timer doesn't fire, and a restarted timer fires at its new time,
+//   - destroying a timer leaves the other running timers intact,
+//   - timers with overlapping slack windows share a single interrupt,
+//   - an early (spurious) interrupt doesn't fire a timer early,
+//   - the callback of an IsrTimer runs in the timer interrupt, at the exact time,
+//   - Flags keep the wait/waitAny/waitAll/hasFired semantics, also when set from an interrupt,
+//   - waits with a timeout return false after the timeout, and true if a waitable fired in time,
+//   - a Queue is ready as long as it holds messages, also when written from an interrupt,
+//   - an EventDispatcher runs the handler of the fired waitable with the highest priority first,
+//   - DeferredWork runs the items of several producers (tasks and an interrupt) in order, counts
+//     the items that didn't fit in its ring, and runs items posted by its items in the same batch,
+//   - with CRT_MAX_NOF_WAITABLES: a task with more than 32 waitables (the two-level event mask).
+// Build it with -DCRT_TASK_NOTIFICATION_EVENTS and/or -DCRT_MAX_NOF_WAITABLES=100 as well,
+// to test those variants of Task.
+// It returns 1 at the first failure.
+// The whole file is guarded with CRT_SIM: the stm project compiles all sources under src/internals.
+
+#ifdef CRT_SIM
+
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+
+#include "crt_Sim.h"
+#include "crt_CleanRTOS.h"
+
+using namespace crt;
+
+namespace crt_testsim
+{
+	static bool bFailed = false;
+
+	static void check(bool bOk, const char* description, uint64_t value, uint64_t expected)
+	{
+		if (bOk) return;
+		printf("FAIL: %s: %" PRIu64 ", expected %" PRIu64 "\n", description, value, expected);
+		bFailed = true;
+	}
+
+	static void checkEqual(const char* description, uint64_t value, uint64_t expected)
+	{
+		check(value == expected, description, value, expected);
+	}
+
+	static uint64_t arIsrFire_us[8];
+	static uint32_t nofIsrFires = 0;
+	static bool bIsrFireInIsr = true;
+
+	static void onIsrTimer(void* /*pArg*/)
+	{
+		if (nofIsrFires < 8) arIsrFire_us[nofIsrFires] = sim::now_us();
+		nofIsrFires++;
+		bIsrFireInIsr &= (__get_IPSR() != 0U);
+	}
+
+	static bool bDestroyedTimerFired = false;
+
+	static void onDestroyedTimer(void* /*pArg*/)
+	{
+		bDestroyedTimerFired = true;
+	}
+
+	static Flag* pIsrFlag = nullptr;
+
+	static void onIsrSetFlag(void* /*pArg*/)
+	{
+		pIsrFlag->set();
+	}
+
+	static Queue<uint32_t, 4>* pIsrQueue = nullptr;
+
+	static void onIsrWriteQueue(void* /*pArg*/)
+	{
+		pIsrQueue->write(42);
+	}
+
+	// The worker is not scheduled in the simulation: the test runs its items with runPostedItems,
+	// like its main does after a wakeup.
+	class TestDeferredWork : public DeferredWork<4>
+	{
+	public:
+		TestDeferredWork() : DeferredWork<4>("TestDeferredWork", osPriorityAboveNormal, 1024)
+		{}
+
+		using DeferredWork<4>::runPostedItems;
+	};
+
+	static TestDeferredWork* pDeferredWork = nullptr;
+	static uint32_t arWorkDone[16];	// per item run: 100 * producer + payload.
+	static uint32_t nofWorkDone = 0;
+	static bool bIsrPostOk = false;
+	static constexpr uintptr_t CHAIN_PRODUCER = 4; // its items post their successor, till payload 0.
+
+	static void onWork(void* pArg, uint32_t payload)
+	{
+		if (nofWorkDone < 16) arWorkDone[nofWorkDone] = 100 * (uint32_t)(uintptr_t)pArg + payload;
+		nofWorkDone++;
+		if (((uintptr_t)pArg == CHAIN_PRODUCER) && (payload > 0))
+		{
+			pDeferredWork->post(onWork, pArg, payload - 1); // posted while the worker runs.
+		}
+	}
+
+	static void onIsrPostWork(void* /*pArg*/)
+	{
+		bIsrPostOk = pDeferredWork->post(onWork, (void*)3, 0);
+	}
+
+	static uint32_t arDispatched[4];
+	static uint32_t nofDispatched = 0;
+
+	static void onDispatch(void* pArg)
+	{
+		if (nofDispatched < 4) arDispatched[nofDispatched] = (uint32_t)(uintptr_t)pArg;
+		nofDispatched++;
+	}
+
+	// The tests are run by main, via the functions of this task (tasks are not scheduled in the simulation).
+	class TestTask : public Task
+	{
+	public:
+		Timer timerA;
+		Timer timerB;
+		Flag flagA;
+		Flag flagB;
+		Queue<uint32_t, 4> queue;
+		EventDispatcher<> dispatcher; // a member, not a local of main (see crt_EventDispatcher.h).
+
+		TestTask() : Task("TestTask", osPriorityNormal, 1024), timerA(this), timerB(this), flagA(this), flagB(this),
+		             queue(this), dispatcher(this)
+		{
+			start();
+		}
+
+		void main() override {}
+
+		void testSleep()
+		{
+			uint64_t start_us = sim::now_us();
+			timerA.sleep_us(5000);
+			checkEqual("sleep_us(5000)", sim::now_us() - start_us, 5000);
+
+			start_us = sim::now_us();
+			timerA.sleep_us(123457);
+			checkEqual("sleep_us(123457)", sim::now_us() - start_us, 123457);
+		}
+
+		void testFixedRate()
+		{
+			sim::setInterruptLatency(7 * sim::COUNTS_PER_US); // every fire is handled 7us late.
+			uint64_t start_us = sim::now_us();
+			timerA.start_periodic(1000, PeriodMode::FixedRate);
+			for (uint64_t i = 1; i <= 100; i++)
+			{
+				wait(timerA);
+				checkEqual("FixedRate fire time", sim::now_us() - start_us, i * 1000 + 7);
+			}
+			timerA.stop();
+			sim::setInterruptLatency(0);
+		}
+
+		void testOverrunSkip()
+		{
+			timerA.start_periodic(1000, PeriodMode::FixedRate, OverrunPolicy::Skip);
+			wait(timerA);
+			uint64_t grid_us = sim::now_us();
+
+			// Handling of the next fire is delayed by 3.5 periods (f.e. by a long critical section).
+			sim::setInterruptLatency(3500 * sim::COUNTS_PER_US);
+			wait(timerA);
+			checkEqual("late fire", sim::now_us() - grid_us, 4500);
+			sim::setInterruptLatency(0);
+
+			// The periods that were missed, are skipped: the next fire is on the grid again.
+			wait(timerA);
+			checkEqual("fire after skip", sim::now_us() - grid_us, 5000);
+			checkEqual("overruns", timerA.getOverrunCount(), 3);
+			timerA.stop();
+		}
+
+		void testLongTimer()
+		{
+			// A small hardware range forces several rearms.
+			Timers::setMaxHwDelta_us(1000000);
+			uint32_t nofInterrupts = sim::getNofDeadlineInterrupts();
+			uint64_t start_us = sim::now_us();
+			timerA.sleep_us(10500000);
+			checkEqual("long sleep", sim::now_us() - start_us, 10500000);
+			checkEqual("interrupts of long sleep", sim::getNofDeadlineInterrupts() - nofInterrupts, 11);
+
+			// Beyond 32 bits of microseconds.
+			Timers::setMaxHwDelta_us(Timers::defaultMaxHwDelta_us);
+			start_us = sim::now_us();
+			timerA.sleep_us(5000000000ull);
+			checkEqual("sleep beyond 32 bits", sim::now_us() - start_us, 5000000000ull);
+		}
+
+		void testStopAndRestart()
+		{
+			uint64_t start_us = sim::now_us();
+			timerA.start(1000);
+			timerB.start(3000);
+			sim::advance_us(500);
+			timerA.stop();
+			timerB.start(2000); // restart: from now.
+			waitAny(timerA + timerB);
+			check(hasFired(timerB) && !hasFired(timerA), "only the restarted timer fires", 0, 0);
+			checkEqual("restarted fire time", sim::now_us() - start_us, 2500);
+		}
+
+		// Like the calibration at startup: destroy a timer while others run.
+		void testDestroyTimer()
+		{
+			uint64_t start_us = sim::now_us();
+			timerA.start(1000);
+			TimerHandle hTimer = Timers::createTimer("destroyed", onDestroyedTimer, nullptr);
+			Timers::startTimer(hTimer, 500, false /*bPeriodic*/);
+			sim::advance_us(200);
+			Timers::destroyTimer(hTimer);
+			check(!Timers::isValidTimerHandle(hTimer), "destroyTimer releases the handle", 0, 0);
+			wait(timerA);
+			checkEqual("fire time after destroying another timer", sim::now_us() - start_us, 1000);
+			check(!bDestroyedTimerFired, "a destroyed timer doesn't fire", 0, 0);
+		}
+
+		void testSlack()
+		{
+			uint32_t nofInterrupts = sim::getNofDeadlineInterrupts();
+			uint64_t start_us = sim::now_us();
+			timerA.start(1000, 500);	// window [1000, 1500]
+			timerB.start(1200, 500);	// window [1200, 1700]: overlaps.
+			waitAll(timerA + timerB);
+			checkEqual("slack: both fire at the first deadline", sim::now_us() - start_us, 1500);
+			checkEqual("slack: shared interrupts", sim::getNofDeadlineInterrupts() - nofInterrupts, 1);
+		}
+
+		void testSpuriousInterrupt()
+		{
+			uint64_t start_us = sim::now_us();
+			timerA.start(1000);
+			sim::advance_us(400);
+			sim::injectHwTimerInterrupt();
+			check(!isSet(timerA), "no fire at a spurious interrupt", 0, 0);
+			wait(timerA);
+			checkEqual("fire time after a spurious interrupt", sim::now_us() - start_us, 1000);
+		}
+
+		void testIsrTimer()
+		{
+			IsrTimer isrTimer(onIsrTimer);
+			uint64_t start_us = sim::now_us();
+			isrTimer.start_periodic(250, PeriodMode::FixedRate);
+			sim::advance_us(250 * 8 + 100);
+			isrTimer.stop();
+			sim::advance_us(1000);
+
+			checkEqual("IsrTimer: amount of callbacks", nofIsrFires, 8);
+			for (uint32_t i = 0; i < 8; i++)
+			{
+				checkEqual("IsrTimer: callback time", arIsrFire_us[i] - start_us, (i + 1) * 250);
+			}
+			check(bIsrFireInIsr, "IsrTimer: callback in the timer interrupt", 0, 0);
+			check(!isrTimer.isRunning(), "IsrTimer: stopped", 0, 0);
+		}
+
+		void testFlags()
+		{
+			// waitAny leaves the bits set, until hasFired consumes them.
+			flagB.set();
+			waitAny(flagA + flagB);
+			check(!hasFired(flagA) && hasFired(flagB), "waitAny: only flagB fired", 0, 0);
+			check(!isSet(flagB), "hasFired clears the fired flag", 0, 0);
+
+			// waitAll waits for both, and clears them.
+			flagA.set();
+			check(isSet(flagA) && !isAllSet(flagA + flagB), "isAllSet needs all flags", 0, 0);
+			pIsrFlag = &flagB;
+			IsrTimer isrTimer(onIsrSetFlag); // sets flagB from the timer interrupt.
+			uint64_t start_us = sim::now_us();
+			isrTimer.start(300);
+			waitAll(flagA + flagB);
+			checkEqual("waitAll: flag set from an interrupt", sim::now_us() - start_us, 300);
+			check(!isSet(flagA) && !isSet(flagB), "waitAll clears the flags", 0, 0);
+
+			// clear undoes a set.
+			flagA.set();
+			flagA.clear();
+			check(!isSet(flagA), "clear", 0, 0);
+		}
+
+		void testQueue()
+		{
+			// Written from an interrupt: waitAny wakes, and the queue stays ready until it is empty.
+			pIsrQueue = &queue;
+			IsrTimer isrTimer(onIsrWriteQueue);
+			uint64_t start_us = sim::now_us();
+			isrTimer.start(500);
+			waitAny(queue + flagA);
+			checkEqual("queue: waitAny time", sim::now_us() - start_us, 500);
+			check(hasFired(queue) && !hasFired(flagA), "queue: fired", 0, 0);
+			queue.write(43);
+			check(hasFired(queue), "queue: still ready after hasFired", 0, 0);
+			uint32_t message = 0;
+			queue.read(message);
+			checkEqual("queue: first message", message, 42);
+			check(isSet(queue), "queue: ready with a message left", 0, 0);
+			queue.read(message);
+			checkEqual("queue: second message", message, 43);
+			check(!isSet(queue), "queue: not ready when empty", 0, 0);
+
+			// waitAll needs the queue and the flag.
+			queue.write(44);
+			check(!waitAll_ticks(queue + flagA, 2), "queue: waitAll without the flag", 0, 0);
+			flagA.set();
+			check(waitAll_ticks(queue + flagA, 2), "queue: waitAll", 0, 0);
+			check(isSet(queue) && !isSet(flagA), "queue: waitAll clears the flag, not the queue", 0, 0);
+			queue.clear();
+			check(!isSet(queue), "queue: not ready after clear", 0, 0);
+		}
+
+		void testEventDispatcher()
+		{
+			dispatcher.add(timerB, onDispatch, (void*)1);
+			dispatcher.add(flagA, onDispatch, (void*)2);
+			dispatcher.add(flagB, onDispatch, (void*)3);
+
+			// flagA was constructed before flagB: it has the higher priority.
+			flagB.set();
+			flagA.set();
+			uint64_t start_us = sim::now_us();
+			timerB.start(400);
+			dispatcher.dispatchNext();
+			dispatcher.dispatchNext();
+			dispatcher.dispatchNext();
+			checkEqual("dispatch: amount", nofDispatched, 3);
+			checkEqual("dispatch: first", arDispatched[0], 2);
+			checkEqual("dispatch: second", arDispatched[1], 3);
+			checkEqual("dispatch: third", arDispatched[2], 1);
+			checkEqual("dispatch: timer time", sim::now_us() - start_us, 400);
+			check(!dispatcher.dispatchNext_ticks(2), "dispatch: timeout", 0, 0);
+			checkEqual("dispatch: amount after timeout", nofDispatched, 3);
+		}
+
+		void testDeferredWork()
+		{
+			static TestDeferredWork work;
+			pDeferredWork = &work;
+
+			// Several producers: "tasks" 1 and 2 (the test itself), and an interrupt (producer 3).
+			check(work.post(onWork, (void*)1, 0), "deferred work: post 1", 0, 0);
+			check(work.post(onWork, (void*)2, 0), "deferred work: post 2", 0, 0);
+			IsrTimer isrTimer(onIsrPostWork);
+			isrTimer.start(200);
+			sim::advance_us(300);
+			check(bIsrPostOk, "deferred work: post from an interrupt", 0, 0);
+			check(work.post(onWork, (void*)1, 1), "deferred work: post 1 again", 0, 0);
+
+			// A wakeup runs all posted items, in the order of posting.
+			checkEqual("deferred work: batch", work.runPostedItems(), 4);
+			const uint32_t arExpected[4] = {100, 200, 300, 101};
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				checkEqual("deferred work: order", arWorkDone[i], arExpected[i]);
+			}
+			checkEqual("deferred work: empty after the batch", work.runPostedItems(), 0);
+
+			// The ring holds 4 items. The items that don't fit are dropped, and counted,
+			// also when posted from an interrupt.
+			for (uint32_t i = 0; i < 4; i++)
+			{
+				check(work.post(onWork, (void*)1, 10 + i), "deferred work: post till full", i, 0);
+			}
+			check(!work.post(onWork, (void*)2, 0), "deferred work: post when full", 0, 0);
+			isrTimer.start(200);
+			sim::advance_us(300);
+			check(!bIsrPostOk, "deferred work: post from an interrupt when full", 0, 0);
+			checkEqual("deferred work: overflows", work.getNofOverflows(), 2);
+			checkEqual("deferred work: batch after overflow", work.runPostedItems(), 4);
+			checkEqual("deferred work: last item that fitted", arWorkDone[7], 113);
+
+			// Items posted while the worker runs, are run in the same batch, also beyond QUEUE_SIZE.
+			check(work.post(onWork, (void*)CHAIN_PRODUCER, 7), "deferred work: post chain", 0, 0);
+			checkEqual("deferred work: chain batch", work.runPostedItems(), 8);
+			checkEqual("deferred work: chain last", arWorkDone[15], 100 * CHAIN_PRODUCER);
+			checkEqual("deferred work: items done", work.getNofItemsDone(), 16);
+			checkEqual("deferred work: max batch", work.getMaxBatchSize(), 8);
+			checkEqual("deferred work: no overflows in the chain", work.getNofOverflows(), 2);
+		}
+
+		void testTimeouts()
+		{
+			// Nothing fires: the waits give up after the timeout (1 tick = 1000 us in the simulation).
+			uint64_t start_us = sim::now_us();
+			check(!waitAny_us(flagA + flagB, 5000), "waitAny_us times out", 0, 0);
+			check(!hasFired(flagA) && !hasFired(flagB), "nothing fired after a timeout", 0, 0);
+			uint64_t waited_us = sim::now_us() - start_us;
+			check((waited_us >= 4000) && (waited_us <= 6000), "waitAny_us timeout duration", waited_us, 5000);
+
+			flagA.set();
+			check(!waitAll_ticks(flagA + flagB, 3), "waitAll_ticks times out with one flag", 0, 0);
+			check(isSet(flagA), "a timed out waitAll doesn't clear", 0, 0);
+			flagA.clear();
+
+			// A flag that is set from an interrupt before the timeout.
+			pIsrFlag = &flagB;
+			IsrTimer isrTimer(onIsrSetFlag);
+			start_us = sim::now_us();
+			isrTimer.start(700);
+			check(wait_us(flagB, 5000), "wait_us fires in time", 0, 0);
+			checkEqual("wait_us fire time", sim::now_us() - start_us, 700);
+			check(!wait_ticks(flagB, 0), "wait_ticks(0) polls", 0, 0);
+		}
+	};
+
+#ifdef CRT_MAX_NOF_WAITABLES
+	// A task with waitables in several groups of the two-level event mask.
+	class ManyFlagsTask : public Task
+	{
+	public:
+		static constexpr uint32_t NOF_FLAGS = 70;
+		Flag arFlags[NOF_FLAGS];
+
+		ManyFlagsTask() : Task("ManyFlagsTask", osPriorityNormal, 1024)
+		{
+			for (Flag& flag : arFlags) flag.init(this);
+			start();
+		}
+
+		void main() override {}
+
+		void testManyFlags()
+		{
+			// Flags 3 and 35 share group bits with others, flag 66 is in a group of its own.
+			arFlags[4].set(); // same group as flag 3: not waited for.
+			pIsrFlag = &arFlags[35];
+			IsrTimer isrTimer(onIsrSetFlag);
+			uint64_t start_us = sim::now_us();
+			isrTimer.start(200);
+			waitAny(arFlags[3] + arFlags[35] + arFlags[66]);
+			checkEqual("many flags: waitAny time", sim::now_us() - start_us, 200);
+			check(!hasFired(arFlags[3]) && hasFired(arFlags[35]) && !hasFired(arFlags[66]),
+			      "many flags: only flag 35 fired", 0, 0);
+			check(isSet(arFlags[4]) && !isSet(arFlags[35]), "many flags: hasFired clears only flag 35", 0, 0);
+
+			arFlags[66].set();
+			arFlags[3].set();
+			waitAll(arFlags[3] + arFlags[66]);
+			check(!isSet(arFlags[3]) && !isSet(arFlags[66]) && isSet(arFlags[4]), "many flags: waitAll", 0, 0);
+			arFlags[4].clear();
+		}
+	};
+#endif
+
+	static int run()
+	{
+		static Time time; // timer5: the virtual clock.
+		Timers::setOverheads(0, 0, true); // no calibration in the simulation: exact times.
+
+		static TestTask testTask;
+		testTask.testSleep();
+		testTask.testFixedRate();
+		testTask.testOverrunSkip();
+		testTask.testLongTimer();
+		testTask.testStopAndRestart();
+		testTask.testDestroyTimer();
+		testTask.testSlack();
+		testTask.testSpuriousInterrupt();
+		testTask.testIsrTimer();
+		testTask.testFlags();
+		testTask.testTimeouts();
+		testTask.testQueue();
+		testTask.testEventDispatcher();
+		testTask.testDeferredWork();
+#ifdef CRT_MAX_NOF_WAITABLES
+		static ManyFlagsTask manyFlagsTask;
+		manyFlagsTask.testManyFlags();
+#endif
+
+		if (bFailed) return 1;
+		printf("Sim: Timers, Timer and Time: all tests passed (virtual time %" PRIu64 " us, %" PRIu32 " interrupts).\n",
+		       sim::now_us(), sim::getNofInterrupts());
+		return 0;
+	}
+}; // end namespace crt_testsim
+
+int main()
+{
+	return crt_testsim::run();
+}
+
+#endif // CRT_SIM
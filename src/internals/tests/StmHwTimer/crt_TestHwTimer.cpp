@@ -47,14 +47,29 @@ namespace crt_hwtimer
 	}
 
 	private:
+		static inline void fireAfter(uint32_t time_us)
+		{
+#ifdef CRT_TIMER2_FREE_RUNNING
+			timer2_fire_at_us(TIMER2_CHANNEL_1, timer2_now() + time_us); // counter is not reset.
+#else
+			timer2_fire_after_us(time_us);
+#endif
+		}
+
 		void main() override
 		{
 			int32_t testUserData = 42;
 
 			printf("timer init\n\r");
 			osDelay(100);
+#ifdef CRT_TIMER2_FREE_RUNNING
+			// Free-running counter, deadline via compare channel 1.
+			timer2_init_free_running();
+			timer2_set_compare_callback(TIMER2_CHANNEL_1, TestHwTimerTask::timerCallback, &testUserData);
+#else
 			timer2_init();
 			timer2_set_callback(TestHwTimerTask::timerCallback, &testUserData);
+#endif
 
 			printf("PCLK1: %lu\n", HAL_RCC_GetPCLK1Freq()); // check CLK1 freq
 			osDelay(100);
@@ -63,7 +78,7 @@ namespace crt_hwtimer
 			uint32_t timerTime_us=1;
 
 			startCycleCount();
-			timer2_fire_after_us(timerTime_us); // start een one-shot timer van 2 µs
+			fireAfter(timerTime_us); // start een one-shot timer van 2 µs
 
 			while (true)
 			{
@@ -80,7 +95,7 @@ namespace crt_hwtimer
 					nPrevCycleCount = getCycleCount();
 					while(nCountFires<100) // measure clockticks of 100 consequtive timer sets and fires.
 					{
-						if(bGlobal!=0) { bGlobal=0;timer2_fire_after_us(timerTime_us);nCountFires++;}
+						if(bGlobal!=0) { bGlobal=0;fireAfter(timerTime_us);nCountFires++;}
 					}
 					nCycles = getCycleCount()-nPrevCycleCount;
 					//osThreadYield();
@@ -0,0 +1,211 @@
+// Host-side benchmark of the timer queue engines of Timers_template.
+//
+// It runs on a PC (not on the stm): the timer queue engines have no hardware dependencies.
+// Build and run, from this folder:
+//   g++ -O2 -std=c++17 -DCRT_SIM -I../.. crt_BenchTimerQueues.cpp -o benchTimerQueues && ./benchTimerQueues
+//
+// For every number of active (running) timers, it reports the time spent in the part of
+// Timers_template::startTimers_impl and stopTimer_impl that runs with interrupts masked:
+//   restart : remove + insert + getFirst  (startTimer on a running timer)
+//   fire    : popFirst + insert           (a periodic timer that fires and is rescheduled)
+// Both as average and as 99.9 percentile (in nanoseconds on the host; the ratio between the
+// engines is what matters, the absolute values are much higher on the mcu).
+// (The maximum is not reported: on a PC, it is dominated by preemption of the benchmark.)
+// Before measuring, it verifies that all engines fire the timers at the same times.
+// The whole file is guarded with CRT_SIM: the stm project compiles all sources under src/internals.
+
+#ifdef CRT_SIM
+
+#include <cstdio>
+#include <cstdint>
+#include <cinttypes>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "crt_TimerQueue_SortedList.h"
+#include "crt_TimerQueue_TimingWheel.h"
+#include "crt_TimerQueue_BinaryHeap.h"
+
+using namespace crt;
+
+namespace crt_benchtimerqueues
+{
+	constexpr int32_t MAX_NOF_TIMERS = 4000;
+
+	template <template <typename, int32_t> class TIMER_QUEUE>
+	struct BenchTimer
+	{
+		uint64_t wakeTime_us = 0;
+		uint32_t period_us = 0;
+		typename TIMER_QUEUE<BenchTimer, MAX_NOF_TIMERS>::Hook queueHook;
+
+		inline uint64_t getQueueKey() const { return wakeTime_us; }
+	};
+
+	struct Result
+	{
+		double   avg_ns = 0;
+		uint64_t p999_ns = 0;
+	};
+
+	static Result summarize(std::vector<uint64_t>& samples)
+	{
+		Result r;
+		uint64_t total = 0;
+		for (uint64_t dt : samples) total += dt;
+		r.avg_ns = (double)total / samples.size();
+		std::sort(samples.begin(), samples.end());
+		r.p999_ns = samples[(samples.size() * 999) / 1000];
+		return r;
+	}
+
+	static inline uint64_t now_ns()
+	{
+		return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	// Periods as used by typical CleanRTOS applications: 100us .. 1s.
+	static uint32_t randomPeriod(std::mt19937& rng)
+	{
+		static const uint32_t periods[] = { 100, 250, 1'000, 2'000, 10'000, 50'000, 100'000, 1'000'000 };
+		uint32_t base = periods[rng() % (sizeof(periods)/sizeof(periods[0]))];
+		return base + (rng() % (base/4 + 1));
+	}
+
+	template <template <typename, int32_t> class TIMER_QUEUE>
+	class Bench
+	{
+		using Timer = BenchTimer<TIMER_QUEUE>;
+		using Queue = TIMER_QUEUE<Timer, MAX_NOF_TIMERS>;
+
+		std::vector<Timer> timers;
+		Queue* pQueue;
+		uint64_t now_us = 0;
+
+	public:
+		Bench(int nofTimers, uint32_t seed) : timers(nofTimers), pQueue(new Queue())
+		{
+			std::mt19937 rng(seed);
+			for (Timer& t : timers)
+			{
+				t.period_us = randomPeriod(rng);
+				t.wakeTime_us = now_us + (rng() % t.period_us) + 1;
+				pQueue->insert(t);
+			}
+		}
+
+		~Bench() { delete pQueue; }
+
+		// Let the first timer fire and reschedule it (like reschedulePeriodicsAndRearm).
+		// Returns the time at which it fired.
+		uint64_t fireNext()
+		{
+			Timer* t = pQueue->popFirst();
+			now_us = t->wakeTime_us;
+			pQueue->advance(now_us);
+			t->wakeTime_us = now_us + t->period_us;
+			pQueue->insert(*t);
+			return now_us;
+		}
+
+		Result measureFire(int nofIterations)
+		{
+			std::vector<uint64_t> samples(nofIterations);
+			for (int i = 0; i < nofIterations; i++)
+			{
+				uint64_t t0 = now_ns();
+				fireNext();
+				samples[i] = now_ns() - t0;
+			}
+			return summarize(samples);
+		}
+
+		Result measureRestart(int nofIterations, uint32_t seed)
+		{
+			std::mt19937 rng(seed);
+			std::vector<uint64_t> samples(nofIterations);
+			volatile uintptr_t sink = 0;
+			for (int i = 0; i < nofIterations; i++)
+			{
+				Timer& t = timers[rng() % timers.size()];
+				uint64_t wake = now_us + randomPeriod(rng);
+
+				uint64_t t0 = now_ns();
+				pQueue->remove(t);
+				t.wakeTime_us = wake;
+				pQueue->insert(t);
+				sink = (uintptr_t)pQueue->getFirst();
+				samples[i] = now_ns() - t0;
+
+				if ((i % 8) == 0) fireNext(); // let time proceed.
+			}
+			(void)sink;
+			return summarize(samples);
+		}
+	};
+
+	// (the order among timers that fire at the same time may differ)
+	static bool verifySameFiringTimes(int nofTimers)
+	{
+		Bench<TimerQueue_SortedList>  list(nofTimers, 1234);
+		Bench<TimerQueue_TimingWheel> wheel(nofTimers, 1234);
+		Bench<TimerQueue_BinaryHeap>  heap(nofTimers, 1234);
+		for (int i = 0; i < 20 * nofTimers; i++)
+		{
+			uint64_t t = list.fireNext();
+			if ((wheel.fireNext() != t) || (heap.fireNext() != t))
+			{
+				printf("MISMATCH in firing times at fire %d (nofTimers=%d)\n", i, nofTimers);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	static void run()
+	{
+		printf("Timer queue engines: interrupt-masked time per operation vs nof running timers\n");
+
+		for (int n : { 10, 100, 1000 })
+		{
+			if (!verifySameFiringTimes(n)) return;
+		}
+		printf("Firing times of SortedList, TimingWheel and BinaryHeap are identical.\n");
+
+		const int nofIterations = 200'000;
+		const int nofTimersList[] = { 1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 4000 };
+
+		for (bool bRestart : { true, false })
+		{
+			printf("\n%s\n", bRestart ? "restart (remove + insert + getFirst):" : "fire (popFirst + insert):");
+			printf("%8s | %22s | %22s | %22s\n", "", "SortedList", "TimingWheel", "BinaryHeap");
+			printf("%8s | %10s %11s | %10s %11s | %10s %11s\n", "timers",
+			       "avg ns", "p99.9 ns", "avg ns", "p99.9 ns", "avg ns", "p99.9 ns");
+
+			for (int n : nofTimersList)
+			{
+				Bench<TimerQueue_SortedList>  list(n, 42);
+				Bench<TimerQueue_TimingWheel> wheel(n, 42);
+				Bench<TimerQueue_BinaryHeap>  heap(n, 42);
+
+				Result rList  = bRestart ? list.measureRestart(nofIterations, 7)  : list.measureFire(nofIterations);
+				Result rWheel = bRestart ? wheel.measureRestart(nofIterations, 7) : wheel.measureFire(nofIterations);
+				Result rHeap  = bRestart ? heap.measureRestart(nofIterations, 7)  : heap.measureFire(nofIterations);
+
+				printf("%8d | %10.1f %11" PRIu64 " | %10.1f %11" PRIu64 " | %10.1f %11" PRIu64 "\n", n,
+				       rList.avg_ns, rList.p999_ns, rWheel.avg_ns, rWheel.p999_ns, rHeap.avg_ns, rHeap.p999_ns);
+			}
+		}
+	}
+};// end namespace crt_benchtimerqueues
+
+int main()
+{
+	crt_benchtimerqueues::run();
+	return 0;
+}
+
+#endif // CRT_SIM
@@ -65,6 +65,9 @@ namespace crt_testtimers
 		// Call doAutoTests() to do all automatic tests.
 		static void doAutoTests()					{doAutoTests_impl();}
 
+		// Call benchIsrDuration() to measure the duration of the timer interrupt handling.
+		static void benchIsrDuration()				{benchIsrDuration_impl();}
+
 	private:
 		// === Implementations ===
 		static void testTimers_human_readable_impl()
@@ -77,6 +80,9 @@ namespace crt_testtimers
 
 			printf("Amount of corresponding size in bytes that Timers takes: %" PRIu32 "\r\n",
 				   crt::Timers::getMemUsageBytes());
+
+			printf("Of which per timer: %" PRIu32 "\r\n",
+				   crt::Timers::getMemUsagePerTimerBytes());
 			osDelay(500);
 
 			crt::TimerHandle hTimer1 = crt::Timers::createTimer("myTimer", myCallback1, &myUserArg);
@@ -165,6 +171,66 @@ namespace crt_testtimers
 			assert(myPeriodicTimerCount<=50); // otherwise stopping above has failed.
 		}
 
+		static void myCallbackBench(void* /*userArg*/)
+		{
+			myPeriodicTimerCount++;
+		}
+
+		static void benchIsrDuration_impl()
+		{
+			printf("\r\n------benchIsrDuration----------\r\n");
+
+			// The timer interrupt used to call Time::getTimeMicroseconds (a 64 bit multiply and divide).
+			// Now it calls Time::getTotalCycleCount. Cost of both, in cycles:
+			const uint32_t N = 1000;
+			volatile uint64_t sink = 0;
+			uint32_t c0 = getCycleCount();
+			for (uint32_t i = 0; i < N; i++) { sink = Time::getTimeMicroseconds(); }
+			uint32_t c1 = getCycleCount();
+			for (uint32_t i = 0; i < N; i++) { sink = Time::getTotalCycleCount(); }
+			uint32_t c2 = getCycleCount();
+			(void)sink;
+			printf("Time::getTimeMicroseconds : %" PRIu32 " cycles per call (before: called in every timer interrupt)\r\n", (c1 - c0) / N);
+			printf("Time::getTotalCycleCount  : %" PRIu32 " cycles per call (now)\r\n", (c2 - c1) / N);
+
+#ifdef CRT_TIMERS_MEASURE_ISR
+			// Duration of the complete timer interrupt handling, with 1 periodic timer.
+			crt::TimerHandle hTimer = crt::Timers::createTimer("benchTimer", myCallbackBench, &myUserArg);
+			myPeriodicTimerCount = 0;
+			crt::Timers::resetIsrDurationCycles();
+			crt::Timers::startTimer(hTimer, 500/*duration_us*/, true/*bPeriodic*/);
+			osDelay(1000);
+			crt::Timers::stopTimer(hTimer);
+			crt::Timers::destroyTimer(hTimer);
+
+			uint32_t max = 0, avg = 0, nofMeasured = 0;
+			crt::Timers::getIsrDurationCycles(max, avg, nofMeasured);
+			printf("Timer interrupt: avg %" PRIu32 " cycles, max %" PRIu32 " cycles (%" PRIu32 " interrupts, core clock %" PRIu32 " Hz)\r\n",
+			       avg, max, nofMeasured, (uint32_t)SystemCoreClock);
+			myPeriodicTimerCount = 0;
+#else
+			printf("Define CRT_TIMERS_MEASURE_ISR in crt_Config.h to measure the duration of the timer interrupt.\r\n");
+#endif
+
+#ifdef CRT_TIMER_STATISTICS
+			// Lateness of the fires of 2 periodic timers, that sometimes fire simultaneously.
+			crt::TimerHandle hTimerA = crt::Timers::createTimer("statsTimerA", myCallbackBench, &myUserArg);
+			crt::TimerHandle hTimerB = crt::Timers::createTimer("statsTimerB", myCallbackBench, &myUserArg);
+			crt::Timers::startTimer(hTimerA, 500/*duration_us*/, true/*bPeriodic*/, PeriodMode::FixedRate);
+			crt::Timers::startTimer(hTimerB, 1500/*duration_us*/, true/*bPeriodic*/, PeriodMode::FixedRate);
+			osDelay(1000);
+			crt::Timers::stopTimer(hTimerA);
+			crt::Timers::stopTimer(hTimerB);
+			crt::Timers::dumpStats();
+			crt::Timers::destroyTimer(hTimerA);
+			crt::Timers::destroyTimer(hTimerB);
+			myPeriodicTimerCount = 0;
+#else
+			printf("Define CRT_TIMER_STATISTICS in crt_Config.h to collect the lateness statistics of timers.\r\n");
+#endif
+			printf("-------------------------------------------\r\n");
+		}
+
 		static void testTimers_auto_impl()
 		{
 			printf("Auto - testing Timers" "\r\n");
@@ -178,6 +244,7 @@ namespace crt_testtimers
 		void main() override
 		{
 			vTaskDelay(10); // wait for init of dependencies.
+			while (!crt::Timers::isCalibrated()) { osDelay(1); } // the calibration uses timers as well.
 			uint32_t iTestRun = 0;
 			while (true)
 			{
@@ -186,6 +253,7 @@ namespace crt_testtimers
 				printf("Test run: %" PRIu32 "\r\n", iTestRun++);
 				testTimers_human_readable();
 				doAutoTests();
+				benchIsrDuration();
 
 				dumpStackHighWaterMarkIfIncreased(); 		// This function call takes about 0.25ms! It should be called while debugging only.
 
@@ -876,6 +876,104 @@ namespace crt_testtime
 			osDelay(500);
 		}
 
+		// Test the count itself: its frequency, no lost counts over a second,
+		// and monotonic with interrupts disabled (for the timer5 source: overflow pending).
+		void test_count_source()
+		{
+			printTitle("test_count_source");
+			osDelay(500);
+
+			uint32_t frequency = Time::getCountFrequency();
+			printf("  Count frequency: %lu Hz\r\n", frequency);
+
+			uint64_t c0 = Time::getTotalCycleCount();
+			osDelay(1000);
+			uint64_t c1 = Time::getTotalCycleCount();
+			printf("  Counts during osDelay(1000), expected ~frequency: ");
+			print_u64("", c1 - c0);
+
+			bool success = true;
+			uint32_t primask_bit = __get_PRIMASK();
+			__disable_irq();
+			uint64_t prev = Time::getTotalCycleCount();
+			for (int i = 0; i < 100000; ++i)
+			{
+				uint64_t curr = Time::getTotalCycleCount();
+				if (curr < prev) success = false;
+				prev = curr;
+			}
+			__set_PRIMASK(primask_bit);
+
+			if (success)
+			{
+				printf("  PASS: count is monotonic with interrupts disabled.\r\n");
+			}
+			else
+			{
+				printf("  FAIL: count went backwards with interrupts disabled!\r\n");
+			}
+			osDelay(500);
+		}
+
+		// With CRT_TICKLESS_IDLE, the cpu sleeps without tick during long osDelays.
+		// Time and the FreeRTOS tick count must still advance by the delay.
+		void test_tickless_continuity()
+		{
+			printTitle("test_tickless_continuity");
+			osDelay(500);
+
+			printf("  Time until next Timers deadline: ");
+			print_u64("", Timers::getTimeUntilNextDeadline_us()); // UINT64_MAX: no timer running.
+
+			uint64_t t0 = Time::getTimeMicroseconds();
+			uint32_t ticks0 = osKernelGetTickCount();
+			osDelay(5000);
+			uint64_t t1 = Time::getTimeMicroseconds();
+			uint32_t ticks1 = osKernelGetTickCount();
+
+			printf("  osDelay(5000): us passed, expected ~5000000: ");
+			print_u64("", t1 - t0);
+			printf("  ticks passed, expected ~5000: %lu\r\n", ticks1 - ticks0);
+			osDelay(500);
+		}
+
+		// Many short tickless sleeps: a part of a tick lost, or a tick counted twice, per sleep
+		// adds up. The FreeRTOS tick count must stay within a tick or two of Time.
+		void test_tickless_short_sleeps()
+		{
+			printTitle("test_tickless_short_sleeps");
+			osDelay(500);
+
+			const uint32_t nofSleeps = 1000;
+			const uint32_t tickFrequency = osKernelGetTickFreq();
+
+			uint64_t t0 = Time::getTimeMicroseconds();
+			uint32_t ticks0 = osKernelGetTickCount();
+			for (uint32_t i = 0; i < nofSleeps; i++)
+			{
+				osDelay(3); // just above the minimum sleep of the tickless idle (2 ticks).
+			}
+			uint64_t t1 = Time::getTimeMicroseconds();
+			uint32_t ticks1 = osKernelGetTickCount();
+
+			uint64_t ticksByTime = ((t1 - t0) * tickFrequency) / 1000000;
+			uint32_t ticksPassed = ticks1 - ticks0;
+			int64_t drift = (int64_t)ticksPassed - (int64_t)ticksByTime;
+
+			printf("  %lu x osDelay(3): ticks passed %lu, by Time ", nofSleeps, ticksPassed);
+			print_u64("", ticksByTime);
+
+			if ((drift >= -2) && (drift <= 2))
+			{
+				printf("  PASS: the tick count follows Time.\r\n");
+			}
+			else
+			{
+				printf("  FAIL: the tick count drifted %ld ticks from Time!\r\n", (long)drift);
+			}
+			osDelay(500);
+		}
+
 	private:
 		void main() override
 		{
@@ -895,6 +993,15 @@ namespace crt_testtime
 				test_instance_access();
 				osDelay(1000);
 
+				test_count_source();
+				osDelay(1000);
+
+				test_tickless_continuity();
+				osDelay(1000);
+
+				test_tickless_short_sleeps();
+				osDelay(1000);
+
 				test_getTimeMicroseconds_basic();
 				osDelay(1000);
 
@@ -90,11 +90,12 @@ namespace crt_testtimer
 	        print_u64(label, dt);
 	    }
 
-	    static void overwriteMaxHwTime(Timer& timer, uint64_t nofBitsHwTimer)
+	    static void overwriteMaxHwTime(Timer& /*timer*/, uint64_t nofBitsHwTimer)
 	    {
-	    	// Redefine maxHwTime to a much lower value, to allow for shorter tests.
-	    	// We can do that because TestTimer is a friend class of Timer.
-            timer.setMaxHwTime ((uint32_t)((((uint64_t)1)<<nofBitsHwTimer)-1));
+	    	// Cap the hardware timer programming of Timers at a much lower value, to allow for shorter tests.
+	    	// Long deadlines are then reached via several rearms of the hardware timer.
+	    	if (nofBitsHwTimer >= 32) { Timers::setMaxHwDelta_us(Timers::defaultMaxHwDelta_us); return; }
+            Timers::setMaxHwDelta_us((uint32_t)((((uint64_t)1)<<nofBitsHwTimer)-1));
 	    }
 
 	    // ----------- tests -----------------------------------------------------
@@ -208,6 +209,32 @@ namespace crt_testtimer
 			}
 		}
 
+		// -------- 1b) calibrated overhead compensation -------------------------
+		void test_calibration()
+		{
+			printTitle("test_calibration");
+			osDelay(500);
+			// The overheads are measured at startup by TimerCalibration.
+			// With them, short one-shot timers should wake within a few us of the requested time.
+			printf("[calibration] calibrated=%d, engine overhead=%lu us, timer overhead=%lu us\r\n",
+			       (int)Timers::isCalibrated(), Timers::getEngineOverhead_us(), Timers::getTimerOverhead_us());
+
+			for (uint32_t us : { 100u, 200u, 500u, 1'000u, 5'000u })
+			{
+				int32_t minLate = INT32_MAX, maxLate = INT32_MIN;
+				for (int i=0; i<10; i++)
+				{
+					uint64_t t0 = now_us();
+					sleepTimer.sleep_us(us);
+					int32_t late = (int32_t)(now_us() - t0) - (int32_t)us;
+					if (late < minLate) minLate = late;
+					if (late > maxLate) maxLate = late;
+				}
+				printf("[calibration] sleep_us(%lu): lateness min=%ld us, max=%ld us\r\n", us, (long)minLate, (long)maxLate);
+				osDelay(100);
+			}
+		}
+
 		// -------- 2) one-shot long (> UINT32_MAX) ------------------------------
 		void test_one_shot_long()
 		{
@@ -217,7 +244,7 @@ namespace crt_testtimer
 			// Use only when you are OK to wait that long, or temporarily lower nofBitsHwTimer
 			// in your Timer to make “long” shorter during validation. :contentReference[oaicite:2]{index=2}
 
-			const uint64_t us = (uint64_t)UINT32_MAX + 12'345; // chunked via relay
+			const uint64_t us = (uint64_t)UINT32_MAX + 12'345; // several rearms of the hardware timer
 
 			{
 				print_u64("[one_shot_long] start us = ", us);
@@ -271,6 +298,53 @@ namespace crt_testtimer
 			periodicTimer.stop();
 		}
 
+		// -------- 3b) periodic drift: FixedDelay vs FixedRate -------------------
+		void test_periodic_fixed_rate()
+		{
+			printTitle("test_periodic_fixed_rate");
+			osDelay(500);
+			// FixedDelay adds the handling latency of each fire to the next period, so the
+			// time of the N-th fire drifts away from start + N*period.
+			// FixedRate should stay on that grid (drift within a few us, not growing with N).
+			const uint32_t period_us = 1'000; // 1 ms
+			const int N = 1000;
+
+			for (PeriodMode mode : { PeriodMode::FixedDelay, PeriodMode::FixedRate })
+			{
+				uint64_t t0 = now_us();
+				periodicTimer.start_periodic(period_us, mode, OverrunPolicy::Skip);
+				for (int i=0; i<N; ++i) {
+					wait(periodicTimer);
+				}
+				uint64_t t1 = now_us();
+				uint32_t nofOverruns = periodicTimer.getOverrunCount();
+				periodicTimer.stop();
+
+				int64_t drift = (int64_t)(t1 - t0) - (int64_t)N * period_us;
+				printf("[periodic_fixed_rate] %s: drift after %d periods = %ld us, overruns = %lu\r\n",
+				       (mode == PeriodMode::FixedRate) ? "FixedRate " : "FixedDelay", N, (long)drift, nofOverruns);
+				osDelay(500);
+			}
+
+			// Overrun: block this task (and the timer interrupt) for 5.5 periods, from the fire at 1 ms.
+			// The fire of 2 ms is delivered late, at about 6.55 ms. Skip continues on the grid (at 7 ms),
+			// and counts the missed periods: those of 3, 4, 5 and 6 ms.
+			const uint32_t expectedOverruns = 4;
+			periodicTimer.start_periodic(period_us, PeriodMode::FixedRate, OverrunPolicy::Skip);
+			wait(periodicTimer);
+			taskENTER_CRITICAL();
+			uint64_t tBusy = now_us();
+			while ((now_us() - tBusy) < 5'500) {}
+			taskEXIT_CRITICAL();
+			wait(periodicTimer);
+			uint32_t nofOverruns = periodicTimer.getOverrunCount();
+			periodicTimer.stop();
+			printf("[periodic_fixed_rate] Skip: overruns after blocking 5.5 periods = %lu (%s)\r\n", nofOverruns,
+			       (nofOverruns == expectedOverruns) ? "OK" : "ERROR: expected 4");
+			osDelay(500);
+			assert(nofOverruns == expectedOverruns);
+		}
+
 		// -------- 4) periodic long --------------------------------------------
 		void test_periodic_long()
 		{
@@ -309,11 +383,11 @@ namespace crt_testtimer
 			osDelay(500);
 			// Verkort HW-timer naar 20 bits zodat de randwaarden in seconden vallen.
 			//overwriteMaxHwTime(sleepTimer, 20); // ~1.048.575 us max
-			const uint64_t e1 = (uint64_t)sleepTimer.getMaxHwTime() - 1; // friend: toegestaan
-			const uint64_t e2 = (uint64_t)sleepTimer.getMaxHwTime();
-			const uint64_t e3 = (uint64_t)sleepTimer.getMaxHwTime() + 1; // forceert long-pad
+			const uint64_t e1 = (uint64_t)Timers::getMaxHwDelta_us() - 1;
+			const uint64_t e2 = (uint64_t)Timers::getMaxHwDelta_us();
+			const uint64_t e3 = (uint64_t)Timers::getMaxHwDelta_us() + 1; // forceert een rearm
 
-			printf("[edges] around maxHwTime: ");
+			printf("[edges] around maxHwDelta: ");
 			print_u64("e1=", e1);  print_u64("e2=", e2);  print_u64("e3=", e3);
 			osDelay(500);
 
@@ -369,7 +443,7 @@ namespace crt_testtimer
 		{
 			printTitle("test_stop_during_chunk");
 			osDelay(500);
-			// For long timers this validates run-id cancellation; this short variant
+			// For long timers this validates cancellation between rearms; this short variant
 			// verifies “stop before fire” never delivers a spurious event.
 			const uint32_t us = 2'000'000; // 2s
 			const bool bShorten=true;
@@ -463,6 +537,123 @@ namespace crt_testtimer
 			osDelay(500);
 		}
 
+		// -------- 11b) slack: coalescing of timers with overlapping windows -----
+		void test_slack_coalescing()
+		{
+			printTitle("test_slack_coalescing");
+			osDelay(500);
+			// Four periodic timers with nearby periods. Without slack, each fire needs an interrupt
+			// of its own. With 2ms slack, most fires should be taken along by a neighbour.
+			const uint32_t periods_us[4] = { 10'000, 10'300, 10'700, 11'100 };
+			Timer* timers[4] = { &tA, &tB, &tC, &tD };
+			const uint32_t duration_ms = 2000;
+
+			for (uint32_t slack_us : { 0u, 2'000u })
+			{
+				uint32_t nofIrqBefore       = Timers::getNofHwTimerInterrupts();
+				uint32_t nofCoalescedBefore = Timers::getNofCoalescedFires();
+
+				for (int i=0; i<4; i++) {
+					timers[i]->start_periodic(periods_us[i], PeriodMode::FixedDelay, OverrunPolicy::Skip, slack_us);
+				}
+
+				uint32_t nofFires = 0;
+				uint64_t t0 = now_us();
+				while ((now_us() - t0) < (uint64_t)duration_ms * 1000) {
+					waitAny(tA + tB + tC + tD);
+					for (int i=0; i<4; i++) {
+						if (hasFired(*timers[i])) nofFires++;
+					}
+				}
+				for (int i=0; i<4; i++) {
+					timers[i]->stop();
+				}
+
+				printf("[slack] slack=%lu us: fires=%lu, hw interrupts=%lu, coalesced fires=%lu\r\n",
+				       slack_us, nofFires,
+				       Timers::getNofHwTimerInterrupts() - nofIrqBefore,
+				       Timers::getNofCoalescedFires() - nofCoalescedBefore);
+				osDelay(500);
+			}
+		}
+
+		// -------- 11c) TimerGroup: staggered phases, one reference instant --------
+		void test_timer_group()
+		{
+			printTitle("test_timer_group");
+			osDelay(500);
+			// Four periodic timers with the same period and phases 0, 2.5, 5 and 7.5 ms.
+			// Started as a group, the phase differences are exact (same reference instant),
+			// and the timers stay in phase (FixedRate).
+			const uint32_t period_us = 10'000;
+			const uint32_t phaseStep_us = 2'500;
+			Timer* timers[4] = { &tA, &tB, &tC, &tD };
+			TimerGroup<4> group;
+			for (int i=0; i<4; i++) {
+				group.add_periodic(*timers[i], period_us, i*phaseStep_us, PeriodMode::FixedRate);
+			}
+
+			uint32_t nofIrqBefore = Timers::getNofHwTimerInterrupts();
+			uint64_t arFired_us[4] = {};
+			uint64_t t0 = now_us();
+			group.start();
+			for (int nofFired = 0; nofFired < 4; ) {
+				waitAny(tA + tB + tC + tD);
+				uint64_t t = now_us();
+				for (int i=0; i<4; i++) {
+					if (hasFired(*timers[i]) && (arFired_us[i] == 0)) { arFired_us[i] = t; nofFired++; }
+				}
+			}
+			group.stop();
+
+			for (int i=0; i<4; i++) {
+				printf("[group] timer %d fired after %lu us (expected %lu us)\r\n", i,
+				       (uint32_t)(arFired_us[i] - t0), period_us + i*phaseStep_us);
+			}
+			printf("[group] hw interrupts: %lu\r\n", Timers::getNofHwTimerInterrupts() - nofIrqBefore);
+			osDelay(500);
+		}
+
+		// -------- 11d) fire-to-wakeup latency: direct ISR delivery vs relay ----
+		// Lateness of the wakeup of this task after a Timer fire (the calibrated overhead
+		// compensation applies to both paths, so the difference is what matters).
+		void measureDeliveryLatency(const char* label)
+		{
+			const uint32_t N = 50;
+			const uint32_t duration_us = 1000;
+			int32_t min_us = INT32_MAX, max_us = INT32_MIN;
+			int64_t total_us = 0;
+			for (uint32_t i = 0; i < N; i++)
+			{
+				uint64_t t0 = Time::getTotalCycleCount();
+				tA.start(duration_us);
+				wait(tA);
+				uint64_t t1 = Time::getTotalCycleCount();
+				int32_t late_us = (int32_t)Time::cyclesToMicroseconds(t1 - t0) - (int32_t)duration_us;
+				if (late_us < min_us) min_us = late_us;
+				if (late_us > max_us) max_us = late_us;
+				total_us += late_us;
+			}
+			printf("[delivery] %-8s lateness: min %ld us, avg %ld us, max %ld us\r\n",
+			       label, (long)min_us, (long)(total_us / N), (long)max_us);
+		}
+
+		void test_delivery_latency()
+		{
+			printTitle("test_delivery_latency");
+			osDelay(500);
+#ifdef CRT_TIMER_DIRECT_ISR_DELIVERY
+			tA.setDirectDelivery(false);
+			measureDeliveryLatency("relay");
+			tA.setDirectDelivery(true);
+			measureDeliveryLatency("direct");
+#else
+			measureDeliveryLatency("relay");
+			printf("[delivery] define CRT_TIMER_DIRECT_ISR_DELIVERY in crt_Config.h to compare with direct delivery.\r\n");
+#endif
+			osDelay(500);
+		}
+
 		// -------- 12) relay queue almost full (documentation harness) ----------
 		void test_queue_almost_full()
 		{
@@ -666,8 +857,12 @@ namespace crt_testtimer
 				osDelay(1000);
 				test_one_shot_short();
 				osDelay(1000);
+				test_calibration();
+				osDelay(1000);
 				test_periodic_short();
 				osDelay(1000);
+				test_periodic_fixed_rate();
+				osDelay(1000);
 				test_min_duration_fudge();
 				osDelay(1000);
 				test_stop_during_chunk();
@@ -678,6 +873,12 @@ namespace crt_testtimer
 				osDelay(1000);
 				test_multiple_timers_simultaneous();
 				osDelay(1000);
+				test_slack_coalescing();
+				osDelay(1000);
+				test_timer_group();
+				osDelay(1000);
+				test_delivery_latency();
+				osDelay(1000);
 				test_queue_almost_full();
 				osDelay(1000);
 				test_gpio_timing_accuracy();